@@ -0,0 +1,100 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_ARENA_H_
+#define FLATBUFFERS_ARENA_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace flatbuffers {
+
+// An allocator for batches of short-lived buffers: memory is handed out from
+// large blocks by bumping a pointer, and deallocate() does nothing. All memory
+// is instead freed at once by reset(), or when the arena is destroyed.
+// Many builders can share one arena (but not from multiple threads at once).
+// Buffers released from those builders (with ReleaseBufferPointer()) remain
+// valid until the arena is reset.
+// Since memory isn't reused until reset(), a builder that grows copies its
+// buffer into new arena memory each time. If messages vary a lot in size,
+// consider FlatBufferBuilder::SetSegmented(), which never copies.
+class arena_allocator : public simple_allocator {
+ public:
+  explicit arena_allocator(size_t block_size = 64 * 1024)
+    : block_size_(AlignSize(block_size)), current_(0), used_(0) {}
+
+  ~arena_allocator() {
+    for (auto it = blocks_.begin(); it != blocks_.end(); ++it) delete[] *it;
+    FreeLargeBlocks();
+  }
+
+  uint8_t *allocate(size_t size) const {
+    size = AlignSize(size);
+    // Allocations that would waste too much of a block get their own.
+    if (size > block_size_ / 4) {
+      large_blocks_.push_back(new uint8_t[size]);
+      return large_blocks_.back();
+    }
+    if (used_ + size > block_size_ || blocks_.empty()) {
+      if (!blocks_.empty()) current_++;
+      if (current_ == blocks_.size())
+        blocks_.push_back(new uint8_t[block_size_]);
+      used_ = 0;
+    }
+    auto p = blocks_[current_] + used_;
+    used_ += size;
+    return p;
+  }
+
+  void deallocate(uint8_t *) const {}
+
+  // Frees all memory handed out so far, but keeps the blocks themselves
+  // around for the next batch.
+  void reset() {
+    FreeLargeBlocks();
+    current_ = 0;
+    used_ = 0;
+  }
+
+  // The number of blocks of memory currently held by the arena.
+  size_t num_blocks() const { return blocks_.size() + large_blocks_.size(); }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  arena_allocator(const arena_allocator &);
+  arena_allocator &operator=(const arena_allocator &);
+
+  static size_t AlignSize(size_t size) {
+    return (size + sizeof(largest_scalar_t) - 1) &
+           ~(sizeof(largest_scalar_t) - 1);
+  }
+
+  void FreeLargeBlocks() {
+    for (auto it = large_blocks_.begin(); it != large_blocks_.end(); ++it)
+      delete[] *it;
+    large_blocks_.clear();
+  }
+
+  // The allocator interface is const, so the arena state is mutable.
+  size_t block_size_;
+  mutable std::vector<uint8_t *> blocks_;
+  mutable std::vector<uint8_t *> large_blocks_;
+  mutable size_t current_;  // Index of the block being allocated from.
+  mutable size_t used_;     // Bytes used in the current block.
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_ARENA_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_BATCH_VERIFIER_H_
+#define FLATBUFFERS_BATCH_VERIFIER_H_
+
+#include <atomic>
+#include <thread>
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/worker_pool.h"
+
+// Verifies many (untrusted) buffers at once, using multiple threads.
+
+namespace flatbuffers {
+
+// A buffer to verify.
+struct BufferRef {
+  const uint8_t *data;
+  size_t size;
+};
+
+// Verify "count" buffers, calling "verify" with a Verifier for each (e.g.
+// the generated VerifyMonsterBuffer, which also checks the file identifier).
+// Sets bit (i % 64) of (*results)[i / 64] if buffer i verified (see
+// BufferVerified below).
+// Buffers are handed out to the threads of "pool" in chunks of 64, so
+// threads that finish early simply take on more chunks, and each result word
+// is only written by one thread. Keep the pool around to verify many batches
+// without starting threads for each.
+// "max_depth" and "max_tables" apply to each buffer (see Verifier).
+template<typename F> void VerifyBuffers(const BufferRef *buffers, size_t count,
+                                        F verify,
+                                        std::vector<uint64_t> *results,
+                                        WorkerPool &pool,
+                                        size_t max_depth = 64,
+                                        size_t max_tables = 1000000) {
+  const size_t kChunkSize = 64;
+  results->assign((count + kChunkSize - 1) / kChunkSize, 0);
+  if (results->empty()) return;
+  std::atomic<size_t> next_chunk(0);
+  pool.Run([&]() {
+    for (;;) {
+      auto chunk = next_chunk++;
+      if (chunk >= results->size()) return;
+      auto start = chunk * kChunkSize;
+      auto end = (std::min)(count, start + kChunkSize);
+      uint64_t bits = 0;
+      for (auto i = start; i < end; i++) {
+        Verifier verifier(buffers[i].data, buffers[i].size, max_depth,
+                          max_tables);
+        if (verify(verifier)) bits |= static_cast<uint64_t>(1) << (i - start);
+      }
+      (*results)[chunk] = bits;
+    }
+  }, results->size());
+}
+
+// Same, using "num_threads" threads (the number of cores if 0) started just
+// for this batch.
+template<typename F> void VerifyBuffers(const BufferRef *buffers, size_t count,
+                                        F verify,
+                                        std::vector<uint64_t> *results,
+                                        size_t num_threads = 0,
+                                        size_t max_depth = 64,
+                                        size_t max_tables = 1000000) {
+  if (!num_threads) num_threads = std::thread::hardware_concurrency();
+  WorkerPool pool((std::max)(static_cast<size_t>(1),
+                             (std::min)(num_threads, (count + 63) / 64)));
+  VerifyBuffers(buffers, count, verify, results, pool, max_depth, max_tables);
+}
+
+// Same, verifying each buffer as having root type T.
+template<typename T> void VerifyBuffers(const BufferRef *buffers, size_t count,
+                                        std::vector<uint64_t> *results,
+                                        WorkerPool &pool,
+                                        size_t max_depth = 64,
+                                        size_t max_tables = 1000000) {
+  VerifyBuffers(buffers, count,
+                [](Verifier &verifier) {
+                  return verifier.VerifyBuffer<T>();
+                },
+                results, pool, max_depth, max_tables);
+}
+
+template<typename T> void VerifyBuffers(const BufferRef *buffers, size_t count,
+                                        std::vector<uint64_t> *results,
+                                        size_t num_threads = 0,
+                                        size_t max_depth = 64,
+                                        size_t max_tables = 1000000) {
+  VerifyBuffers(buffers, count,
+                [](Verifier &verifier) {
+                  return verifier.VerifyBuffer<T>();
+                },
+                results, num_threads, max_depth, max_tables);
+}
+
+// Whether buffer i verified, given the results of VerifyBuffers.
+inline bool BufferVerified(const std::vector<uint64_t> &results, size_t i) {
+  return (results[i / 64] >> (i % 64)) & 1;
+}
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_BATCH_VERIFIER_H_
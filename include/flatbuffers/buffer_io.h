@@ -0,0 +1,367 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_BUFFER_IO_H_
+#define FLATBUFFERS_BUFFER_IO_H_
+
+#include <errno.h>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+  #define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "flatbuffers/flatbuffers.h"
+
+// Reading and writing FlatBuffers directly from/to files, pipes and sockets,
+// without the intermediate copies LoadFile() and SaveFile() in util.h make.
+
+namespace flatbuffers {
+
+#ifndef _WIN32
+// Describe the finished buffer held by "fbb" as a list of memory blocks,
+// without joining them first (see FlatBufferBuilder::SetSegmented()).
+// The iovecs point into the builder, so are only valid until it is
+// modified.
+inline void GetBufferIOVecs(const FlatBufferBuilder &fbb,
+                            std::vector<iovec> *iov) {
+  fbb.Finished();
+  iov->resize(fbb.GetNumSegments());
+  for (size_t i = 0; i < iov->size(); i++) {
+    size_t len;
+    auto data = fbb.GetSegment(i, &len);
+    (*iov)[i].iov_base = const_cast<uint8_t *>(data);
+    (*iov)[i].iov_len = len;
+  }
+}
+
+// Write all "count" blocks in "iov" to file descriptor "fd" (a file, pipe,
+// socket..) with writev(), retrying on partial writes.
+// Returns false on error, with errno set. "iov" is modified.
+inline bool WriteIOVecs(int fd, iovec *iov, size_t count) {
+  #ifdef IOV_MAX
+    const size_t max_count = IOV_MAX;
+  #else
+    const size_t max_count = 16;  // The minimum POSIX allows.
+  #endif
+  while (count) {
+    auto written = writev(fd, iov, static_cast<int>((std::min)(count,
+                                                               max_count)));
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    auto left = static_cast<size_t>(written);
+    while (count && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (left) {
+      iov->iov_base = reinterpret_cast<uint8_t *>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  return true;
+}
+
+// Write the finished buffer held by "fbb" to file descriptor "fd" without
+// first copying it into a single block.
+// Returns false on error, with errno set.
+inline bool WriteBuffer(int fd, const FlatBufferBuilder &fbb) {
+  std::vector<iovec> iov;
+  GetBufferIOVecs(fbb, &iov);
+  return WriteIOVecs(fd, iov.data(), iov.size());
+}
+#endif  // !_WIN32
+
+// A whole file mapped into memory, such that a FlatBuffer in it can be
+// accessed directly (with GetRoot() below), without first reading it all
+// into memory as LoadFile does: pages get loaded as they are accessed, and
+// can be shared between processes.
+class MappedFile {
+ public:
+  enum Mode {
+    kReadOnly,
+    // Writable, with changes private to this mapping, e.g. for mutating a
+    // FlatBuffer in-place (see --gen-mutable) without changing the file.
+    kCopyOnWrite
+  };
+
+  // Access patterns to expect, see Advise().
+  enum Advice { kNormal, kSequential, kRandom, kWillNeed };
+
+  MappedFile() : data_(nullptr), size_(0) {
+    #ifdef _WIN32
+      mapping_ = nullptr;
+    #endif
+  }
+  ~MappedFile() { Close(); }
+
+  // Map file "name", unmapping any file mapped before.
+  // Returns false if it can't be opened or mapped. An empty file can't be
+  // mapped, but isn't an error: it opens with data() nullptr and size() 0
+  // (so check size() before GetRoot()).
+  bool Open(const char *name, Mode mode = kReadOnly) {
+    Close();
+    #ifdef _WIN32
+      auto file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER size;
+      auto ok = GetFileSizeEx(file, &size);
+      if (ok && size.QuadPart) {
+        mapping_ = CreateFileMappingA(file, nullptr,
+                                      mode == kReadOnly ? PAGE_READONLY
+                                                        : PAGE_WRITECOPY,
+                                      0, 0, nullptr);
+        if (mapping_) {
+          data_ = reinterpret_cast<uint8_t *>(
+                    MapViewOfFile(mapping_,
+                                  mode == kReadOnly ? FILE_MAP_READ
+                                                    : FILE_MAP_COPY,
+                                  0, 0, 0));
+        }
+        ok = data_ != nullptr;
+      }
+      CloseHandle(file);
+      if (!ok) {
+        Close();
+        return false;
+      }
+      size_ = static_cast<size_t>(size.QuadPart);
+    #else
+      auto fd = open(name, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      auto ok = fstat(fd, &st) == 0;
+      // mmap() can't map empty files.
+      if (ok && st.st_size) {
+        auto p = mmap(nullptr, static_cast<size_t>(st.st_size),
+                      mode == kReadOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+                      mode == kReadOnly ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        ok = p != MAP_FAILED;
+        if (ok) data_ = reinterpret_cast<uint8_t *>(p);
+      }
+      close(fd);  // The mapping stays valid.
+      if (!ok) return false;
+      size_ = static_cast<size_t>(st.st_size);
+    #endif
+    return true;
+  }
+
+  void Close() {
+    #ifdef _WIN32
+      if (data_) UnmapViewOfFile(data_);
+      if (mapping_) CloseHandle(mapping_);
+      mapping_ = nullptr;
+    #else
+      if (data_) munmap(data_, size_);
+    #endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  // Tell the OS how the mapping will be accessed, e.g. kRandom to avoid
+  // reading ahead when only small parts of a large buffer will be accessed,
+  // or kWillNeed to start loading all of it in the background.
+  // Just a hint: returns false if not supported.
+  bool Advise(Advice advice) {
+    #ifdef _WIN32
+      (void)advice;
+      return false;
+    #else
+      if (!data_) return false;
+      static const int kAdvice[] = {
+        MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED
+      };
+      return madvise(data_, size_, kAdvice[advice]) == 0;
+    #endif
+  }
+
+  const uint8_t *data() const { return data_; }
+  // Only writable when opened with kCopyOnWrite.
+  uint8_t *mutable_data() { return data_; }
+  size_t size() const { return size_; }
+
+  // The root of the FlatBuffer held by the file (which you may want to
+  // verify first, see Verifier).
+  template<typename T> const T *GetRoot() const {
+    return flatbuffers::GetRoot<T>(data_);
+  }
+  template<typename T> T *GetMutableRoot() {
+    return flatbuffers::GetMutableRoot<T>(data_);
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  uint8_t *data_;
+  size_t size_;
+  #ifdef _WIN32
+    HANDLE mapping_;
+  #endif
+};
+
+// Reads a sequence of buffers finished with
+// FlatBufferBuilder::FinishSizePrefixed and stored one after the other (e.g.
+// appended to a log file, or sent over a socket), from memory (such as a
+// MappedFile) or from a file descriptor.
+class FrameReader {
+ public:
+  // Read the frames in "size" bytes at "data".
+  FrameReader(const uint8_t *data, size_t size)
+    : cur_(data), end_(data + size), fd_(-1), eof_(true), error_(false),
+      max_frame_size_(size), max_depth_(64), max_tables_(1000000),
+      num_frames_(0), num_skipped_(0) {}
+
+  #ifndef _WIN32
+  // Read frames from file descriptor "fd" (which is not closed), in blocks
+  // of "buffer_size" bytes or more, into a buffer reused for all frames.
+  // A frame larger than "max_frame_size" is taken to be corrupt.
+  explicit FrameReader(int fd, size_t buffer_size = 1 << 20,
+                       size_t max_frame_size = 1 << 30)
+    : cur_(nullptr), end_(nullptr), fd_(fd), eof_(false), error_(false),
+      max_frame_size_(max_frame_size), max_depth_(64), max_tables_(1000000),
+      num_frames_(0), num_skipped_(0), buffer_(buffer_size) {}
+  #endif
+
+  // Verify each frame with "verify" (e.g. the generated VerifyMonsterBuffer),
+  // and skip frames that fail. "max_depth" and "max_tables" are passed to
+  // each Verifier.
+  void SetVerifier(std::function<bool(Verifier &)> verify,
+                   size_t max_depth = 64, size_t max_tables = 1000000) {
+    verify_ = verify;
+    max_depth_ = max_depth;
+    max_tables_ = max_tables;
+  }
+
+  // Get the next frame, setting "size" to its size (not counting the size
+  // prefix), so it can be read with e.g. GetRoot. Returns nullptr at the end
+  // of the frames, or if they can't be read (see Error()).
+  // The frame is only valid until the next call, and is aligned to
+  // sizeof(largest_scalar_t) (by copying it, if not already).
+  const uint8_t *Next(size_t *size) {
+    for (;;) {
+      if (!Fill(sizeof(uoffset_t))) return nullptr;
+      auto frame_size = GetPrefixedSize(cur_);
+      // Since frames have no marker to resynchronize on, a bad size means
+      // nothing after it can be read.
+      if (frame_size > max_frame_size_) {
+        error_ = true;
+        return nullptr;
+      }
+      if (!Fill(sizeof(uoffset_t) + frame_size)) return nullptr;
+      auto frame = cur_ + sizeof(uoffset_t);
+      cur_ = frame + frame_size;
+      if (reinterpret_cast<uintptr_t>(frame - sizeof(uoffset_t)) %
+          sizeof(largest_scalar_t)) {
+        // The data is aligned relative to where the size prefix would be.
+        scratch_.resize(sizeof(uoffset_t) + frame_size);
+        frame = reinterpret_cast<const uint8_t *>(
+                  memcpy(scratch_.data() + sizeof(uoffset_t), frame,
+                         frame_size));
+      }
+      if (verify_) {
+        Verifier verifier(frame, frame_size, max_depth_, max_tables_);
+        if (!verify_(verifier)) {
+          num_skipped_++;
+          continue;
+        }
+      }
+      num_frames_++;
+      *size = frame_size;
+      return frame;
+    }
+  }
+
+  // Whether reading stopped because of a truncated or oversized frame, or a
+  // read error, rather than at the end of the frames.
+  bool Error() const { return error_; }
+
+  // Frames returned so far, and frames skipped because they failed to verify.
+  size_t NumFrames() const { return num_frames_; }
+  size_t NumSkipped() const { return num_skipped_; }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  FrameReader(const FrameReader &);
+  FrameReader &operator=(const FrameReader &);
+
+  // Make sure "len" bytes are available at cur_, reading more if possible.
+  bool Fill(size_t len) {
+    if (static_cast<size_t>(end_ - cur_) >= len) return true;
+    #ifndef _WIN32
+      if (!eof_ && !error_) {
+        // Move what's left of the last block to the start of the buffer, and
+        // read as much as fits after it.
+        auto filled = static_cast<size_t>(end_ - cur_);
+        if (filled) memmove(buffer_.data(), cur_, filled);
+        if (buffer_.size() < len) buffer_.resize(len);
+        while (filled < len) {
+          auto bytes_read = read(fd_, buffer_.data() + filled,
+                                 buffer_.size() - filled);
+          if (bytes_read < 0) {
+            if (errno == EINTR) continue;
+            error_ = true;
+            break;
+          }
+          if (!bytes_read) {
+            eof_ = true;
+            break;
+          }
+          filled += static_cast<size_t>(bytes_read);
+        }
+        cur_ = buffer_.data();
+        end_ = cur_ + filled;
+        if (filled >= len) return true;
+      }
+    #endif
+    if (cur_ != end_) error_ = true;  // A truncated frame.
+    return false;
+  }
+
+  const uint8_t *cur_;
+  const uint8_t *end_;
+  int fd_;
+  bool eof_;
+  bool error_;
+  size_t max_frame_size_;
+  std::function<bool(Verifier &)> verify_;
+  size_t max_depth_;
+  size_t max_tables_;
+  size_t num_frames_;
+  size_t num_skipped_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> scratch_;  // Holds misaligned frames.
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_BUFFER_IO_H_
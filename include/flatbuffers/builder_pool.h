@@ -0,0 +1,161 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_BUILDER_POOL_H_
+#define FLATBUFFERS_BUILDER_POOL_H_
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "flatbuffers/flatbuffers.h"
+
+// A thread-safe pool of FlatBufferBuilders, for servers that build many
+// messages concurrently: a builder returned to the pool is cleared, but
+// keeps its memory (buffer, vtable index etc.), so building the next message
+// with it usually needs no allocations at all.
+// Idle builders are kept in a fixed number of shards, each with its own
+// mutex, picked by a hash of the calling thread's id. This is not a cache
+// per thread: threads whose ids hash to the same shard share it (and its
+// limit on idle builders), and contend for its lock.
+
+namespace flatbuffers {
+
+class BuilderPool {
+ public:
+  // Builders are created with "initial_size" and "allocator" (see the
+  // FlatBufferBuilder constructor). Builders that have grown beyond
+  // "max_retained_size" bytes (0 for no limit) are deleted rather than kept,
+  // to bound the memory held by the pool, as is anything beyond
+  // "max_cached_per_shard" idle builders in a shard (see kNumShards).
+  explicit BuilderPool(uoffset_t initial_size = 1024,
+                       size_t max_retained_size = 0,
+                       size_t max_cached_per_shard = 16,
+                       const simple_allocator *allocator = nullptr)
+    : initial_size_(initial_size),
+      max_retained_size_(max_retained_size),
+      max_cached_per_shard_(max_cached_per_shard),
+      allocator_(allocator),
+      num_created_(0),
+      num_acquired_(0) {}
+
+  ~BuilderPool() {
+    for (size_t i = 0; i < kNumShards; i++) {
+      auto &builders = shards_[i].builders;
+      for (auto it = builders.begin(); it != builders.end(); ++it) delete *it;
+    }
+  }
+
+  // Get an empty builder, creating it if this thread's shard has none idle.
+  // Hand it back with Release() when done (or use Lease below).
+  FlatBufferBuilder *Acquire() {
+    num_acquired_++;
+    auto &shard = CurrentShard();
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (!shard.builders.empty()) {
+        auto fbb = shard.builders.back();
+        shard.builders.pop_back();
+        return fbb;
+      }
+    }
+    num_created_++;
+    return new FlatBufferBuilder(initial_size_, allocator_);
+  }
+
+  // Return a builder to the pool. Any buffer still in it is discarded, so
+  // call ReleaseBufferPointer() first if you want to keep it. Its settings
+  // (ForceDefaults etc.) are reset too, so they don't carry over to whoever
+  // gets it next.
+  void Release(FlatBufferBuilder *fbb) {
+    // Before Clear(), which would use any BufferSizeStats set, which may
+    // not exist anymore.
+    fbb->ResetSettings();
+    fbb->Clear();
+    if (max_retained_size_ && fbb->GetCapacity() > max_retained_size_) {
+      delete fbb;
+      return;
+    }
+    auto &shard = CurrentShard();
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (shard.builders.size() < max_cached_per_shard_) {
+        shard.builders.push_back(fbb);
+        return;
+      }
+    }
+    delete fbb;
+  }
+
+  // Holds a builder from the pool for as long as it is in scope.
+  class Lease {
+   public:
+    explicit Lease(BuilderPool &pool) : pool_(pool), fbb_(pool.Acquire()) {}
+    ~Lease() { pool_.Release(fbb_); }
+
+    FlatBufferBuilder &operator*() const { return *fbb_; }
+    FlatBufferBuilder *operator->() const { return fbb_; }
+    FlatBufferBuilder *get() const { return fbb_; }
+
+   private:
+    Lease(const Lease &);
+    Lease &operator=(const Lease &);
+
+    BuilderPool &pool_;
+    FlatBufferBuilder *fbb_;
+  };
+
+  // Statistics: how many builders had to be created, out of how many
+  // Acquire() calls.
+  size_t NumCreated() const { return num_created_; }
+  size_t NumAcquired() const { return num_acquired_; }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  BuilderPool(const BuilderPool &);
+  BuilderPool &operator=(const BuilderPool &);
+
+  // The number of shards idle builders are spread over. Since a thread
+  // always uses the same shard, threads on different shards never contend
+  // for a lock, and a builder tends to be reused by the thread that used it
+  // before (with a warm cache). With more threads than shards, some
+  // necessarily share one.
+  static const size_t kNumShards = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<FlatBufferBuilder *> builders;
+  };
+
+  Shard &CurrentShard() {
+    auto id = std::hash<std::thread::id>()(std::this_thread::get_id());
+    // Thread ids are often aligned addresses, so mix in the higher bits.
+    id ^= (id >> 7) ^ (id >> 13) ^ (id >> 23);
+    return shards_[id % kNumShards];
+  }
+
+  uoffset_t initial_size_;
+  size_t max_retained_size_;
+  size_t max_cached_per_shard_;
+  const simple_allocator *allocator_;
+  std::atomic<size_t> num_created_;
+  std::atomic<size_t> num_acquired_;
+  Shard shards_[kNumShards];
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_BUILDER_POOL_H_
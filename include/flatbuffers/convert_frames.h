@@ -0,0 +1,209 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_CONVERT_FRAMES_H_
+#define FLATBUFFERS_CONVERT_FRAMES_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "flatbuffers/reflection.h"
+#include "flatbuffers/buffer_io.h"
+#include "flatbuffers/worker_pool.h"
+
+// Converts a file of size-prefixed FlatBuffers (see FinishSizePrefixed and
+// FrameReader) from one version of a schema to another (see SchemaConverter),
+// using multiple threads.
+
+namespace flatbuffers {
+
+struct ConvertStats {
+  ConvertStats()
+    : num_frames(0), num_failed(0), bytes_in(0), bytes_out(0), seconds(0) {}
+
+  size_t num_frames;  // Frames converted.
+  size_t num_failed;  // Frames that couldn't be converted, and were skipped.
+  size_t bytes_in;    // Size of all frames read, including size prefixes.
+  size_t bytes_out;   // Same, for the frames written.
+  double seconds;
+
+  double FramesPerSecond() const {
+    return seconds > 0 ? num_frames / seconds : 0;
+  }
+  double MegabytesPerSecond() const {
+    return seconds > 0 ? bytes_in / (1024.0 * 1024.0) / seconds : 0;
+  }
+};
+
+// Converts the frames in file "in_path" with "converter" (which must have
+// been compiled), and writes them to file "out_path", in the same order.
+// The threads of "pool" (all of them, for the whole file) each take the next
+// batch of "batch_size" frames, convert it, and then write out whichever
+// converted batches are next in line, so reading and writing overlap with
+// converting. Frames are read straight from the mapped file, and only copied
+// if not aligned to sizeof(largest_scalar_t) (as FrameReader does).
+// Returns false if a file can't be opened or written, or if "in_path" ends in
+// a truncated frame (in which case all frames before it are still written).
+inline bool ConvertFrames(const SchemaConverter &converter,
+                          const char *in_path, const char *out_path,
+                          ConvertStats *stats, WorkerPool &pool,
+                          size_t batch_size = 1024) {
+  auto start_time = std::chrono::steady_clock::now();
+  *stats = ConvertStats();
+  MappedFile in;
+  if (!in.Open(in_path)) return false;
+  in.Advise(MappedFile::kSequential);
+  std::ofstream out(out_path, std::ofstream::binary);
+  if (!out.is_open()) return false;
+  struct Frame {
+    const uint8_t *data;  // nullptr if copied to "pos" in the batch's scratch.
+    size_t pos;
+    size_t size;
+  };
+  struct Batch {
+    std::vector<Frame> frames;
+    std::vector<uint8_t> scratch;  // Copies of misaligned frames.
+    std::vector<uint8_t> out;  // Converted frames, with size prefix.
+    size_t bytes_in;
+    size_t num_failed;
+    bool converted;
+  };
+  // Batches are numbered in the order they are read, and batch i is kept in
+  // batches[i % batches.size()] until written, so each thread can be
+  // converting one while others wait to be written.
+  auto num_threads = pool.NumThreads();
+  std::vector<Batch> batches(2 * num_threads);
+  std::vector<std::unique_ptr<FlatBufferBuilder>> builders;
+  std::vector<std::vector<uoffset_t>> offsets(num_threads);
+  for (size_t i = 0; i < num_threads; i++)
+    builders.push_back(std::unique_ptr<FlatBufferBuilder>(
+                         new FlatBufferBuilder()));
+  // All of these are protected by "mutex".
+  auto cur = in.data();
+  auto end = cur + in.size();
+  bool truncated = false;
+  bool done_reading = false;  // At the end, or unable to write.
+  bool writing = false;       // A thread is writing out batches.
+  size_t next_read = 0;
+  size_t next_write = 0;
+  std::mutex mutex;
+  std::condition_variable batch_written;
+  std::atomic<size_t> next_thread(0);
+  pool.Run([&]() {
+    auto thread = next_thread++;
+    auto &fbb = *builders[thread];
+    auto &thread_offsets = offsets[thread];
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      // Read the next batch, once there's room for it.
+      batch_written.wait(lock, [&]() {
+        return done_reading || next_read - next_write < batches.size();
+      });
+      if (done_reading) return;
+      auto &batch = batches[next_read % batches.size()];
+      batch.frames.clear();
+      batch.scratch.clear();
+      batch.bytes_in = 0;
+      batch.converted = false;
+      while (batch.frames.size() < batch_size && cur != end) {
+        auto left = static_cast<size_t>(end - cur);
+        if (left < sizeof(uoffset_t) ||
+            GetPrefixedSize(cur) > left - sizeof(uoffset_t)) {
+          truncated = true;
+          break;
+        }
+        Frame frame = { cur + sizeof(uoffset_t), 0, GetPrefixedSize(cur) };
+        if (reinterpret_cast<uintptr_t>(cur) % sizeof(largest_scalar_t)) {
+          // The data is aligned relative to where the size prefix would be.
+          frame.pos = ((batch.scratch.size() + sizeof(uoffset_t) - 1) &
+                       ~(sizeof(largest_scalar_t) - 1)) + sizeof(uoffset_t);
+          batch.scratch.resize(frame.pos + frame.size);
+          memcpy(batch.scratch.data() + frame.pos, frame.data, frame.size);
+          frame.data = nullptr;
+        }
+        cur += sizeof(uoffset_t) + frame.size;
+        batch.frames.push_back(frame);
+        batch.bytes_in += sizeof(uoffset_t) + frame.size;
+      }
+      if (batch.frames.empty()) {
+        done_reading = true;
+        batch_written.notify_all();
+        return;
+      }
+      next_read++;
+      lock.unlock();
+      // Convert it, while other threads read, convert and write.
+      batch.out.clear();
+      batch.num_failed = 0;
+      for (auto it = batch.frames.begin(); it != batch.frames.end(); ++it) {
+        fbb.Clear();
+        auto data = it->data ? it->data : batch.scratch.data() + it->pos;
+        if (!converter.Convert(data, it->size, &fbb, true, &thread_offsets)) {
+          batch.num_failed++;
+          continue;
+        }
+        batch.out.insert(batch.out.end(), fbb.GetBufferPointer(),
+                         fbb.GetBufferPointer() + fbb.GetSize());
+      }
+      lock.lock();
+      batch.converted = true;
+      // Write out the converted batches that are next in line, unless another
+      // thread already is (which will then write this one too).
+      if (writing) continue;
+      writing = true;
+      for (;;) {
+        auto &next = batches[next_write % batches.size()];
+        if (next_write == next_read || !next.converted) break;
+        lock.unlock();
+        out.write(reinterpret_cast<const char *>(next.out.data()),
+                  next.out.size());
+        lock.lock();
+        stats->bytes_in += next.bytes_in;
+        stats->bytes_out += next.out.size();
+        stats->num_frames += next.frames.size() - next.num_failed;
+        stats->num_failed += next.num_failed;
+        next.converted = false;
+        next_write++;
+        if (!out) done_reading = true;
+        batch_written.notify_all();
+      }
+      writing = false;
+    }
+  });
+  out.close();
+  stats->seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start_time).count();
+  return !out.fail() && !truncated;
+}
+
+// Same, using "num_threads" threads (the number of cores if 0) started just
+// for this file.
+inline bool ConvertFrames(const SchemaConverter &converter,
+                          const char *in_path, const char *out_path,
+                          ConvertStats *stats, size_t num_threads = 0,
+                          size_t batch_size = 1024) {
+  if (!num_threads) num_threads = std::thread::hardware_concurrency();
+  WorkerPool pool((std::max)(num_threads, static_cast<size_t>(1)));
+  return ConvertFrames(converter, in_path, out_path, stats, pool, batch_size);
+}
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_CONVERT_FRAMES_H_
@@ -28,8 +28,11 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <memory>
 
+#include "flatbuffers/hash.h"
+
 #if __cplusplus <= 199711L && \
     (!defined(_MSC_VER) || _MSC_VER < 1600) && \
     (!defined(__GNUC__) || \
@@ -71,6 +74,17 @@
   #define FLATBUFFERS_FINAL_CLASS
 #endif
 
+// Hint to the CPU that memory at this address will be read soon.
+#if defined(__GNUC__) || defined(__clang__)
+  #define FLATBUFFERS_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  #include <xmmintrin.h>
+  #define FLATBUFFERS_PREFETCH(addr) \
+    _mm_prefetch(reinterpret_cast<const char *>(addr), _MM_HINT_T0)
+#else
+  #define FLATBUFFERS_PREFETCH(addr) ((void)(addr))
+#endif
+
 namespace flatbuffers {
 
 // Our default offset / size type, 32bit on purpose on 64bit systems.
@@ -254,6 +268,88 @@ private:
   const uint8_t *data_;
 };
 
+// Hash of a key, as stored in hash indices (see
+// FlatBufferBuilder::CreateHashIndex). Scalars are hashed in little endian
+// byte order, so indices work across platforms.
+inline uint32_t HashKey(const char *key) { return HashFnv1a<uint32_t>(key); }
+template<typename T> uint32_t HashKey(T key, std::false_type /*is_float*/) {
+  key = EndianScalar(key);
+  return HashFnv1a<uint32_t>(&key, sizeof(key));
+}
+template<typename T> uint32_t HashKey(T key, std::true_type /*is_float*/) {
+  if (key == 0) key = 0;  // -0.0 == 0.0, so must have the same hash.
+  // NaN keys are never found (see Vector::LookupByKey), but all hash alike,
+  // so indices don't depend on the NaN bits.
+  if (key != key) key = std::numeric_limits<T>::quiet_NaN();
+  return HashKey(key, std::false_type());
+}
+template<typename T> uint32_t HashKey(T key) {
+  return HashKey(key, typename std::is_floating_point<T>::type());
+}
+
+// Key prefixes, as stored in key indices (see
+// FlatBufferBuilder::CreateKeyIndex): 64 bit values that sort in the same
+// order as the keys they are made from. Different keys may share a prefix.
+// For strings, that is their first 8 bytes.
+inline uint64_t KeyPrefix(const char *key) {
+  uint64_t prefix = 0;
+  for (int i = 0; i < 8; i++) {
+    prefix <<= 8;
+    if (*key) prefix |= static_cast<unsigned char>(*key++);
+  }
+  return prefix;
+}
+template<typename T> uint64_t KeyPrefix(T key, std::true_type /*is_float*/) {
+  double d = key;
+  if (d == 0) d = 0;  // -0.0 == 0.0, so must have the same prefix.
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  // Negative numbers sort in reverse order of their bits.
+  return bits & (1ULL << 63) ? ~bits : bits | (1ULL << 63);
+}
+template<typename T> uint64_t KeyPrefix(T key, std::false_type /*is_float*/) {
+  // Make negative numbers sort first.
+  return std::is_signed<T>::value
+    ? static_cast<uint64_t>(static_cast<int64_t>(key)) ^ (1ULL << 63)
+    : static_cast<uint64_t>(key);
+}
+template<typename T> uint64_t KeyPrefix(T key) {
+  return KeyPrefix(key, typename std::is_floating_point<T>::type());
+}
+
+// A key index holds the prefixes of the keys of a sorted vector in
+// Eytzinger (breadth first) order, such that a search through it visits
+// adjacent memory for its first steps, rather than jumping across the whole
+// vector. The implicit tree is made complete, filling up with ~0 prefixes,
+// so it holds 2^N - 1 prefixes for N levels.
+inline size_t KeyIndexSize(size_t num_keys) {
+  size_t size = 0;
+  while (size < num_keys) size = size * 2 + 1;
+  return size;
+}
+
+// The position in the sorted vector of node k (1 being the root) of a key
+// index of the given size.
+inline size_t KeyIndexRank(size_t k, size_t size) {
+  size_t level_start = 1;
+  while (level_start * 2 <= k) level_start *= 2;
+  return (2 * (k - level_start) + 1) * ((size + 1) / (level_start * 2)) - 1;
+}
+
+// The position of the first prefix >= "prefix" in the sorted vector, or
+// "size" if none.
+inline size_t KeyIndexLowerBound(const uint64_t *prefixes, size_t size,
+                                 uint64_t prefix) {
+  size_t k = 1;
+  while (k <= size)
+    k = 2 * k + (ReadScalar<uint64_t>(prefixes + k - 1) < prefix);
+  // Undo the turns to the right after the last turn to the left (towards the
+  // smallest prefix >= "prefix"), and that turn itself.
+  while (k & 1) k >>= 1;
+  k >>= 1;
+  return k ? KeyIndexRank(k, size) : size;
+}
+
 // This is used as a helper type for accessing vectors.
 // Vector::data() assumes the vector elements start after the length field.
 template<typename T> class Vector {
@@ -305,7 +401,8 @@ public:
   void MutateOffset(uoffset_t i, const uint8_t *val) {
     assert(i < size());
     assert(sizeof(T) == sizeof(uoffset_t));
-    WriteScalar(data() + i, val - (Data() + i * sizeof(uoffset_t)));
+    WriteScalar(data() + i,
+                static_cast<uoffset_t>(val - (Data() + i * sizeof(uoffset_t))));
   }
 
   // The raw data in little endian format. Use with care.
@@ -322,16 +419,62 @@ public:
   T *data() { return reinterpret_cast<T *>(Data()); }
 
   template<typename K> return_type LookupByKey(K key) const {
-    void *search_result = std::bsearch(&key, Data(), size(),
-        IndirectHelper<T>::element_stride, KeyCompare<K>);
-
-    if (!search_result) {
-      return nullptr;  // Key not found.
+    return SearchByKey(key, 0, size());
+  }
+
+  // Same, using a hash index created by FlatBufferBuilder::CreateHashIndex,
+  // which takes O(1) rather than O(log(size)) steps. Falls back to the binary
+  // search above if there is no index (e.g. in older data).
+  // Like any lookup, finds nothing for a NaN key, which equals no key.
+  template<typename K> return_type LookupByKey(
+                                    K key,
+                                    const Vector<uint32_t> *hash_index) const {
+    auto num_slots = hash_index ? hash_index->size() : 0;
+    if (!num_slots || (num_slots & (num_slots - 1))) return LookupByKey(key);
+    if (key != key) return nullptr;  // NaN.
+    typedef typename std::remove_pointer<return_type>::type element_type;
+    auto mask = num_slots - 1;
+    auto slot = element_type::KeyHashValue(key) & mask;
+    // Stop after visiting every slot, in case the index is corrupt (it always
+    // has empty slots otherwise).
+    for (uoffset_t i = 0; i < num_slots; i++, slot = (slot + 1) & mask) {
+      auto entry = hash_index->Get(slot);
+      if (!entry) break;
+      if (entry > size()) continue;
+      auto element = Get(entry - 1);
+      if (!element->KeyCompareWithValue(key)) return element;
     }
+    return nullptr;
+  }
 
-    const uint8_t *element = reinterpret_cast<const uint8_t *>(search_result);
+  // Same, using a key index created by FlatBufferBuilder::CreateKeyIndex:
+  // this searches a compact array of key prefixes, and only touches tables
+  // whose keys share the prefix of "key". Falls back to the binary search
+  // above if there is no index (e.g. in older data).
+  template<typename K> return_type LookupByKey(
+                                     K key,
+                                     const Vector<uint64_t> *key_index) const {
+    uoffset_t start, n;
+    if (!KeyIndexRange(key, key_index, &start, &n)) return LookupByKey(key);
+    return SearchByKey(key, start, n);
+  }
 
-    return IndirectHelper<T>::Read(element, 0);
+  // The position of the first element with a key >= "key", or size() if
+  // none (or "key" is NaN). Use it to iterate over a range of keys, in a
+  // vector sorted as for LookupByKey.
+  template<typename K> uoffset_t LowerBoundByKey(K key) const {
+    return LowerBound(key, 0, size());
+  }
+
+  // Same, using a key index as above, so only the tables whose keys share
+  // the prefix of "key" are touched.
+  template<typename K> uoffset_t LowerBoundByKey(
+                                   K key,
+                                   const Vector<uint64_t> *key_index) const {
+    uoffset_t start, n;
+    if (!KeyIndexRange(key, key_index, &start, &n))
+      return LowerBoundByKey(key);
+    return LowerBound(key, start, n);
   }
 
 protected:
@@ -342,14 +485,66 @@ protected:
   uoffset_t length_;
 
 private:
-  template<typename K> static int KeyCompare(const void *ap, const void *bp) {
-    const K *key = reinterpret_cast<const K *>(ap);
-    const uint8_t *data = reinterpret_cast<const uint8_t *>(bp);
-    auto table = IndirectHelper<T>::Read(data, 0);
-
-    // std::bsearch compares with the operands transposed, so we negate the
-    // result here.
-    return -table->KeyCompareWithValue(*key);
+  // Binary search of elements [start, start + n) that keeps the last element
+  // <= key in [base, base + n), so picking a half compiles to a conditional
+  // move rather than a branch, and the comparison (KeyCompareWithValue) can
+  // be inlined.
+  template<typename K> return_type SearchByKey(K key, uoffset_t start,
+                                               uoffset_t n) const {
+    // NaN compares neither less nor greater than anything, so would "match"
+    // whichever element the search ends up at.
+    if (!n || key != key) return nullptr;
+    auto base = Data() + start * IndirectHelper<T>::element_stride;
+    while (n > 1) {
+      auto half = n / 2;
+      auto mid = base + half * IndirectHelper<T>::element_stride;
+      base = IndirectHelper<T>::Read(mid, 0)->KeyCompareWithValue(key) <= 0
+        ? mid
+        : base;
+      n -= half;
+    }
+    auto element = IndirectHelper<T>::Read(base, 0);
+    return element->KeyCompareWithValue(key) ? nullptr : element;
+  }
+
+  // The first of elements [start, start + n) with a key >= "key", or
+  // start + n if none.
+  template<typename K> uoffset_t LowerBound(K key, uoffset_t start,
+                                            uoffset_t n) const {
+    if (key != key) return size();  // NaN.
+    while (n) {
+      auto half = n / 2;
+      if (Get(start + half)->KeyCompareWithValue(key) < 0) {
+        start += half + 1;
+        n -= half + 1;
+      } else {
+        n = half;
+      }
+    }
+    return start;
+  }
+
+  // The elements [start, start + n) whose keys share the prefix of "key",
+  // according to "key_index". Any elements before them have smaller keys,
+  // and any after them larger ones. Returns false if there is no (valid)
+  // index.
+  template<typename K> bool KeyIndexRange(K key,
+                                          const Vector<uint64_t> *key_index,
+                                          uoffset_t *start,
+                                          uoffset_t *n) const {
+    if (!key_index || key_index->size() != KeyIndexSize(size())) return false;
+    typedef typename std::remove_pointer<return_type>::type element_type;
+    auto prefix = element_type::KeyPrefixValue(key);
+    auto prefixes = key_index->data();
+    auto begin = KeyIndexLowerBound(prefixes, key_index->size(), prefix);
+    auto end = prefix == 0xFFFFFFFFFFFFFFFFULL
+      ? size()
+      : KeyIndexLowerBound(prefixes, key_index->size(), prefix + 1);
+    end = (std::min)(end, static_cast<size_t>(size()));
+    begin = (std::min)(begin, end);
+    *start = static_cast<uoffset_t>(begin);
+    *n = static_cast<uoffset_t>(end - begin);
+    return true;
   }
 };
 
@@ -388,16 +583,27 @@ struct String : public Vector<char> {
 
 // Simple indirection for buffer allocation, to allow this to be overridden
 // with custom allocation (see the FlatBufferBuilder constructor).
+// Memory must be aligned to at least sizeof(largest_scalar_t).
 class simple_allocator {
  public:
   virtual ~simple_allocator() {}
   virtual uint8_t *allocate(size_t size) const { return new uint8_t[size]; }
   virtual void deallocate(uint8_t *p) const { delete[] p; }
+
+  // The instance used when no allocator is specified. Buffers released from
+  // a builder may outlive it, so this can't be owned by the builder.
+  static const simple_allocator &default_instance() {
+    static simple_allocator instance;
+    return instance;
+  }
 };
 
 // This is a minimal replication of std::vector<uint8_t> functionality,
 // except growing from higher to lower addresses. i.e push_back() inserts data
 // in the lowest address in the vector.
+// In segmented mode, running out of space allocates an additional block
+// (segment) rather than reallocating and copying the whole vector. The data
+// is then only made contiguous when data() is called.
 class vector_downward {
  public:
   explicit vector_downward(size_t initial_size,
@@ -405,6 +611,10 @@ class vector_downward {
     : reserved_(initial_size),
       buf_(allocator.allocate(reserved_)),
       cur_(buf_ + reserved_),
+      top_(cur_),
+      base_(0),
+      segmented_(false),
+      num_reallocations_(0),
       allocator_(allocator) {
     assert((initial_size & (sizeof(largest_scalar_t) - 1)) == 0);
   }
@@ -412,27 +622,35 @@ class vector_downward {
   ~vector_downward() {
     if (buf_)
       allocator_.deallocate(buf_);
+    clear_segments();
   }
 
   void clear() {
     if (buf_ == nullptr)
       buf_ = allocator_.allocate(reserved_);
-
-    cur_ = buf_ + reserved_;
+    // Keep only the most recent (and largest) segment.
+    clear_segments();
+    top_ = buf_ + reserved_;
+    cur_ = top_;
   }
 
   // Relinquish the pointer to the caller.
   unique_ptr_t release() {
+    // Point to the desired offset.
+    auto start = data();
+
     // Actually deallocate from the start of the allocated memory.
+    // The allocator is referred to (not copied, which would slice off any
+    // derived allocator), so it must outlive the returned pointer.
     std::function<void(uint8_t *)> deleter(
-      std::bind(&simple_allocator::deallocate, allocator_, buf_));
+      std::bind(&simple_allocator::deallocate, &allocator_, buf_));
 
-    // Point to the desired offset.
-    unique_ptr_t retval(data(), deleter);
+    unique_ptr_t retval(start, deleter);
 
     // Don't deallocate when this instance is destroyed.
     buf_ = nullptr;
     cur_ = nullptr;
+    top_ = nullptr;
 
     return retval;
   }
@@ -441,19 +659,23 @@ class vector_downward {
     return (bytes / 2) & ~(sizeof(largest_scalar_t) - 1);
   }
 
+  // Smaller than growth_policy, since segments are never copied: this
+  // bounds the unused space at the end of the last segment.
+  size_t segment_growth_policy(size_t bytes) {
+    return (bytes / 4) & ~(sizeof(largest_scalar_t) - 1);
+  }
+
+  void set_segmented(bool segmented) { segmented_ = segmented; }
+
   uint8_t *make_space(size_t len) {
     if (len > static_cast<size_t>(cur_ - buf_)) {
-      auto old_size = size();
-      auto largest_align = AlignOf<largest_scalar_t>();
-      reserved_ += (std::max)(len, growth_policy(reserved_));
-      // Round up to avoid undefined behavior from unaligned loads and stores.
-      reserved_ = (reserved_ + (largest_align - 1)) & ~(largest_align - 1);
-      auto new_buf = allocator_.allocate(reserved_);
-      auto new_cur = new_buf + reserved_ - old_size;
-      memcpy(new_cur, cur_, old_size);
-      cur_ = new_cur;
-      allocator_.deallocate(buf_);
-      buf_ = new_buf;
+      num_reallocations_++;
+      if (segmented_) {
+        add_segment(len);
+      } else {
+        auto capacity = base_ + reserved_;
+        reallocate(capacity + (std::max)(len, growth_policy(capacity)));
+      }
     }
     cur_ -= len;
     // Beyond this, signed offsets may not have enough range:
@@ -462,17 +684,61 @@ class vector_downward {
     return cur_;
   }
 
+  // Make sure len more bytes can be written without reallocating.
+  void reserve(size_t len) {
+    if (len <= static_cast<size_t>(cur_ - buf_)) return;
+    if (segmented_) add_segment(len);
+    else reallocate(size() + len);
+  }
+
+  // The number of times make_space() ran out of space (and reallocated, or
+  // added a segment).
+  size_t num_reallocations() const { return num_reallocations_; }
+
   uoffset_t size() const {
     assert(cur_ != nullptr && buf_ != nullptr);
-    return static_cast<uoffset_t>(reserved_ - (cur_ - buf_));
+    return static_cast<uoffset_t>(base_ + (top_ - cur_));
+  }
+
+  // Total amount of memory allocated.
+  size_t capacity() const {
+    auto total = buf_ ? reserved_ : 0;
+    for (auto it = segments_.begin(); it != segments_.end(); ++it)
+      total += it->reserved;
+    return total;
   }
 
-  uint8_t *data() const {
+  // Returns the contiguous data, joining segments first if needed.
+  uint8_t *data() {
     assert(cur_ != nullptr);
+    if (!segments_.empty()) reallocate(size());
     return cur_;
   }
 
-  uint8_t *data_at(size_t offset) { return buf_ + reserved_ - offset; }
+  // Any object written with a single make_space() call (which includes
+  // vtables and strings) is contiguous, even in segmented mode.
+  uint8_t *data_at(size_t offset) {
+    if (offset > base_) return top_ - (offset - base_);
+    // Find the last segment starting below offset.
+    auto it = std::lower_bound(segments_.begin(), segments_.end(), offset,
+      [](const segment &seg, size_t off) { return seg.base < off; });
+    --it;
+    return it->top - (offset - it->base);
+  }
+
+  size_t num_segments() const { return segments_.size() + 1; }
+
+  // Segment 0 holds the start of the data, i.e. what data() would return,
+  // the last one holds the end.
+  const uint8_t *segment_data(size_t i, size_t *len) const {
+    if (!i) {
+      *len = top_ - cur_;
+      return cur_;
+    }
+    auto &seg = segments_[segments_.size() - i];
+    *len = seg.top - seg.cur;
+    return seg.cur;
+  }
 
   // push() & fill() are most frequently called with small byte counts (<= 4),
   // which is why we're using loops rather than calling memcpy/memset.
@@ -486,16 +752,96 @@ class vector_downward {
     for (size_t i = 0; i < zero_pad_bytes; i++) dest[i] = 0;
   }
 
-  void pop(size_t bytes_to_remove) { cur_ += bytes_to_remove; }
+  void pop(size_t bytes_to_remove) {
+    // Popping past the start of the current segment makes the previous
+    // segment current again.
+    while (bytes_to_remove > static_cast<size_t>(top_ - cur_)) {
+      assert(!segments_.empty());
+      bytes_to_remove -= top_ - cur_;
+      allocator_.deallocate(buf_);
+      auto &seg = segments_.back();
+      reserved_ = seg.reserved;
+      buf_ = seg.buf;
+      cur_ = seg.cur;
+      top_ = seg.top;
+      base_ = seg.base;
+      segments_.pop_back();
+    }
+    cur_ += bytes_to_remove;
+  }
 
  private:
   // You shouldn't really be copying instances of this class.
   vector_downward(const vector_downward &);
   vector_downward &operator=(const vector_downward &);
 
-  size_t reserved_;
+  // A full segment, no longer written to.
+  struct segment {
+    size_t reserved;
+    uint8_t *buf;
+    uint8_t *cur;
+    uint8_t *top;
+    size_t base;
+  };
+
+  // Retires the current segment, and starts a new one with room for at least
+  // len bytes.
+  void add_segment(size_t len) {
+    if (cur_ != top_) {
+      segment seg = { reserved_, buf_, cur_, top_, base_ };
+      segments_.push_back(seg);
+      base_ = seg.base + (top_ - cur_);
+    } else {
+      allocator_.deallocate(buf_);
+    }
+    auto largest_align = AlignOf<largest_scalar_t>();
+    reserved_ = (std::max)(len, segment_growth_policy(base_)) + largest_align;
+    reserved_ = (reserved_ + (largest_align - 1)) & ~(largest_align - 1);
+    buf_ = allocator_.allocate(reserved_);
+    // Offset the end of the segment such that data keeps the same alignment
+    // it would have in a contiguous buffer.
+    top_ = buf_ + reserved_ - (base_ & (largest_align - 1));
+    cur_ = top_;
+  }
+
+  // Moves all data into a single new allocation of (at least) capacity bytes.
+  void reallocate(size_t capacity) {
+    auto old_size = size();
+    auto largest_align = AlignOf<largest_scalar_t>();
+    // Round up to avoid undefined behavior from unaligned loads and stores.
+    capacity = (capacity + (largest_align - 1)) & ~(largest_align - 1);
+    auto new_buf = allocator_.allocate(capacity);
+    auto new_top = new_buf + capacity;
+    memcpy(new_top - old_size, cur_, top_ - cur_);
+    allocator_.deallocate(buf_);
+    for (auto it = segments_.begin(); it != segments_.end(); ++it) {
+      memcpy(new_top - it->base - (it->top - it->cur), it->cur,
+             it->top - it->cur);
+      allocator_.deallocate(it->buf);
+    }
+    segments_.clear();
+    reserved_ = capacity;
+    buf_ = new_buf;
+    top_ = new_top;
+    cur_ = new_top - old_size;
+    base_ = 0;
+  }
+
+  void clear_segments() {
+    for (auto it = segments_.begin(); it != segments_.end(); ++it)
+      allocator_.deallocate(it->buf);
+    segments_.clear();
+    base_ = 0;
+  }
+
+  size_t reserved_;  // Size of the allocation of the current segment.
   uint8_t *buf_;
   uint8_t *cur_;  // Points at location between empty (below) and used (above).
+  uint8_t *top_;  // End of the used part of the current segment.
+  size_t base_;   // Amount of data in earlier segments.
+  bool segmented_;
+  size_t num_reallocations_;
+  std::vector<segment> segments_;  // Earlier segments, oldest first.
   const simple_allocator &allocator_;
 };
 
@@ -513,6 +859,67 @@ inline size_t PaddingBytes(size_t buf_size, size_t scalar_size) {
   return ((~buf_size) + 1) & (scalar_size - 1);
 }
 
+// Keeps track of the sizes of recently built buffers, to predict the size of
+// the next one. Attach it to a FlatBufferBuilder with SetSizeStats(): the
+// builder then records the size of each buffer it finishes, and reserves
+// room for the 95th percentile of recent sizes whenever it is cleared, such
+// that in the steady state buffers get built without reallocations.
+// Sizes usually depend on the kind of message, so use one instance per root
+// type. Not thread-safe.
+class BufferSizeStats {
+ public:
+  // Estimates are based on the last "window" sizes.
+  explicit BufferSizeStats(size_t window = 64)
+    : window_(window), next_(0), estimate_(0), estimate_valid_(true),
+      reallocations_(0), reallocations_avoided_(0) {
+    assert(window);
+  }
+
+  void AddSize(size_t size) {
+    if (sizes_.size() < window_) {
+      sizes_.push_back(size);
+    } else {
+      sizes_[next_] = size;
+      next_ = (next_ + 1) % window_;
+    }
+    estimate_valid_ = false;
+  }
+
+  // The 95th percentile of recent sizes (0 if none were recorded yet).
+  size_t Estimate() const {
+    if (!estimate_valid_) {
+      scratch_ = sizes_;
+      auto nth = scratch_.begin() + scratch_.size() * 95 / 100;
+      std::nth_element(scratch_.begin(), nth, scratch_.end());
+      estimate_ = *nth;
+      estimate_valid_ = true;
+    }
+    return estimate_;
+  }
+
+  void AddReallocations(size_t reallocations, size_t avoided) {
+    reallocations_ += reallocations;
+    reallocations_avoided_ += avoided;
+  }
+
+  // How often builders using these statistics had to reallocate.
+  size_t Reallocations() const { return reallocations_; }
+  // How many more reallocations there would have been without reserving
+  // (an estimate, based on the default growth policy).
+  size_t ReallocationsAvoided() const { return reallocations_avoided_; }
+
+ private:
+  size_t window_;
+  std::vector<size_t> sizes_;  // Circular, once window_ sizes are recorded.
+  size_t next_;
+  // Cached, as Estimate() is called much more often than sizes change.
+  mutable std::vector<size_t> scratch_;
+  mutable size_t estimate_;
+  mutable bool estimate_valid_;
+  size_t reallocations_;
+  size_t reallocations_avoided_;
+};
+
 // Helper class to hold data needed in creation of a flat buffer.
 // To serialize data, you typically call one of the Create*() functions in
 // the generated code, which in turn call a sequence of StartTable/PushElement/
@@ -521,29 +928,75 @@ inline size_t PaddingBytes(size_t buf_size, size_t scalar_size) {
 // Finish() wraps up the buffer ready for transport.
 class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
  public:
+  // A custom allocator must outlive both the builder and any buffer released
+  // from it with ReleaseBufferPointer().
   explicit FlatBufferBuilder(uoffset_t initial_size = 1024,
                              const simple_allocator *allocator = nullptr)
-      : buf_(initial_size, allocator ? *allocator : default_allocator),
-        nested(false), finished(false), minalign_(1), force_defaults_(false) {
+      : buf_(initial_size,
+             allocator ? *allocator : simple_allocator::default_instance()),
+        nested(false), finished(false), num_vtables_(0),
+        next_recent_layout_(0),
+        num_shared_strings_(0), max_shared_strings_(kMaxSharedStrings),
+        minalign_(1),
+        force_defaults_(false), size_stats_(nullptr),
+        reallocations_at_clear_(0), capacity_at_clear_(0) {
     offsetbuf_.reserve(16);  // Avoid first few reallocs.
-    vtables_.reserve(16);
+    vtables_.resize(16);     // Must be a power of 2.
     EndianCheck();
   }
 
   // Reset all the state in this FlatBufferBuilder so it can be reused
   // to construct another buffer.
+  // The vtable and shared string indices keep their capacity, so a reused
+  // builder does not have to grow them again.
   void Clear() {
     buf_.clear();
     offsetbuf_.clear();
     nested = false;
     finished = false;
-    vtables_.clear();
+    ClearHashIndex(&vtables_, &num_vtables_);
+    ClearHashIndex(&shared_strings_, &num_shared_strings_);
+    for (size_t i = 0; i < kNumRecentLayouts; i++)
+      recent_layouts_[i].vtable = 0;
     minalign_ = 1;
+    if (size_stats_) ReserveFromSizeStats();
+  }
+
+  // Put the settings made with ForceDefaults, SetSegmented,
+  // SetSharedStringLimit and SetSizeStats back to their defaults, as for a
+  // new builder (e.g. when handing the builder on to other code). Doesn't
+  // clear the buffer.
+  void ResetSettings() {
+    force_defaults_ = false;
+    buf_.set_segmented(false);
+    max_shared_strings_ = kMaxSharedStrings;
+    size_stats_ = nullptr;
+  }
+
+  // Make room for a buffer of (at least) "size" bytes in total, such that
+  // building it requires no further reallocations.
+  void Reserve(size_t size) {
+    if (size > GetSize()) buf_.reserve(size - GetSize());
   }
 
+  // Record the sizes of finished buffers in "stats", and use them to reserve
+  // room whenever this builder is cleared (see BufferSizeStats).
+  // Pass nullptr to stop doing so.
+  void SetSizeStats(BufferSizeStats *stats) {
+    size_stats_ = stats;
+    if (size_stats_) ReserveFromSizeStats();
+  }
+
+  // The number of times the buffer ran out of space since this builder
+  // was created.
+  size_t GetNumReallocations() const { return buf_.num_reallocations(); }
+
   // The current size of the serialized buffer, counting from the end.
   uoffset_t GetSize() const { return buf_.size(); }
 
+  // The amount of memory allocated to hold the buffer.
+  size_t GetCapacity() const { return buf_.capacity(); }
+
   // Get the serialized buffer (after you call Finish()).
   uint8_t *GetBufferPointer() const {
     Finished();
@@ -553,6 +1006,27 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // Get a pointer to an unfinished buffer.
   uint8_t *GetCurrentBufferPointer() const { return buf_.data(); }
 
+  // Normally the buffer is a single block of memory, which is reallocated
+  // (copying its contents) whenever it runs out of space. In segmented mode,
+  // running out of space allocates an additional block instead, so even
+  // very large buffers are built without copying, and with peak memory use
+  // close to the final size.
+  // The blocks are only joined (once) when you call GetBufferPointer(),
+  // GetCurrentBufferPointer() or ReleaseBufferPointer(). Alternatively,
+  // access them as they are with GetNumSegments() / GetSegment().
+  void SetSegmented(bool segmented) { buf_.set_segmented(segmented); }
+
+  // The number of blocks the buffer currently consists of (1 unless
+  // segmented, see above).
+  size_t GetNumSegments() const { return buf_.num_segments(); }
+
+  // Get block i of the buffer. Concatenated in order, the blocks form the
+  // same bytes as GetBufferPointer() / GetSize().
+  const uint8_t *GetSegment(size_t i, size_t *len) const {
+    assert(i < GetNumSegments());
+    return buf_.segment_data(i, len);
+  }
+
   // Get the released pointer to the serialized buffer.
   // Don't attempt to use this FlatBufferBuilder afterwards!
   // The unique_ptr returned has a special allocator that knows how to
@@ -578,7 +1052,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   void Pad(size_t num_bytes) { buf_.fill(num_bytes); }
 
   void Align(size_t elem_size) {
-    if (elem_size > minalign_) minalign_ = elem_size;
+    TrackMinAlign(elem_size);
     buf_.fill(PaddingBytes(buf_.size(), elem_size));
   }
 
@@ -686,41 +1160,16 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     // Write the vtable offset, which is the start of any Table.
     // We fill it's value later.
     auto vtableoffsetloc = PushElement<soffset_t>(0);
-    // Write a vtable, which consists entirely of voffset_t elements.
-    // It starts with the number of offsets, followed by a type id, followed
-    // by the offsets themselves. In reverse:
-    buf_.fill(numfields * sizeof(voffset_t));
     auto table_object_size = vtableoffsetloc - start;
     assert(table_object_size < 0x10000);  // Vtable use 16bit offsets.
-    PushElement<voffset_t>(static_cast<voffset_t>(table_object_size));
-    PushElement<voffset_t>(FieldIndexToOffset(numfields));
-    // Write the offsets into the table
-    for (auto field_location = offsetbuf_.begin();
-              field_location != offsetbuf_.end();
-            ++field_location) {
-      auto pos = static_cast<voffset_t>(vtableoffsetloc - field_location->off);
-      // If this asserts, it means you've set a field twice.
-      assert(!ReadScalar<voffset_t>(buf_.data() + field_location->id));
-      WriteScalar<voffset_t>(buf_.data() + field_location->id, pos);
-    }
+    // Tables often come in runs with the same layout (e.g. the elements of a
+    // vector), in which case we can point to the vtable of a previous table
+    // without building and looking up a new one.
+    auto vt_use = FindRecentLayout(vtableoffsetloc, table_object_size,
+                                   numfields);
+    if (!vt_use)
+      vt_use = WriteVTable(vtableoffsetloc, table_object_size, numfields);
     offsetbuf_.clear();
-    auto vt1 = reinterpret_cast<voffset_t *>(buf_.data());
-    auto vt1_size = ReadScalar<voffset_t>(vt1);
-    auto vt_use = GetSize();
-    // See if we already have generated a vtable with this exact same
-    // layout before. If so, make it point to the old one, remove this one.
-    for (auto it = vtables_.begin(); it != vtables_.end(); ++it) {
-      auto vt2 = reinterpret_cast<voffset_t *>(buf_.data_at(*it));
-      auto vt2_size = *vt2;
-      if (vt1_size != vt2_size || memcmp(vt2, vt1, vt1_size)) continue;
-      vt_use = *it;
-      buf_.pop(GetSize() - vtableoffsetloc);
-      break;
-    }
-    // If this is a new vtable, remember it.
-    if (vt_use == GetSize()) {
-      vtables_.push_back(vt_use);
-    }
     // Fill the vtable offset we created above.
     // The offset points from the beginning of the object to where the
     // vtable is stored.
@@ -738,7 +1187,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // just been constructed.
   template<typename T> void Required(Offset<T> table, voffset_t field) {
     auto table_ptr = buf_.data_at(table.o);
-    auto vtable_ptr = table_ptr - ReadScalar<soffset_t>(table_ptr);
+    auto vtable_ptr = buf_.data_at(table.o + ReadScalar<soffset_t>(table_ptr));
     bool ok = ReadScalar<voffset_t>(vtable_ptr + field) != 0;
     // If this fails, the caller will show what field needs to be set.
     assert(ok);
@@ -768,9 +1217,13 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   Offset<String> CreateString(const char *str, size_t len) {
     NotNested();
     PreAlign<uoffset_t>(len + 1);  // Always 0-terminated.
-    buf_.fill(1);
-    PushBytes(reinterpret_cast<const uint8_t *>(str), len);
-    PushElement(static_cast<uoffset_t>(len));
+    TrackMinAlign(sizeof(uoffset_t));
+    // Write the length, contents and terminator in one go, such that the
+    // string is contiguous (even in segmented mode).
+    auto dest = buf_.make_space(sizeof(uoffset_t) + len + 1);
+    WriteScalar(dest, static_cast<uoffset_t>(len));
+    memcpy(dest + sizeof(uoffset_t), str, len);
+    dest[sizeof(uoffset_t) + len] = 0;
     return Offset<String>(GetSize());
   }
 
@@ -786,6 +1239,56 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     return CreateString(str->c_str(), str->Length());
   }
 
+  // Like CreateString, but if a string with the exact same contents was
+  // already stored in this buffer by an earlier CreateSharedString call,
+  // returns the offset of that string instead of storing it again.
+  // Useful for data with many repeated strings (names, tags, keys...).
+  Offset<String> CreateSharedString(const char *str, size_t len) {
+    NotNested();
+    if (shared_strings_.empty()) shared_strings_.resize(16);
+    auto hash = HashFnv1a<uint32_t>(str, len);
+    auto mask = shared_strings_.size() - 1;
+    auto slot = hash & mask;
+    for (; shared_strings_[slot].off; slot = (slot + 1) & mask) {
+      auto &loc = shared_strings_[slot];
+      if (loc.hash != hash) continue;
+      auto s = reinterpret_cast<const String *>(buf_.data_at(loc.off));
+      if (s->size() == len && !memcmp(s->c_str(), str, len))
+        return Offset<String>(loc.off);
+    }
+    auto off = CreateString(str, len);
+    // Once the pool is full, strings are simply no longer shared.
+    if (num_shared_strings_ < max_shared_strings_) {
+      HashedOffset loc = { off.o, hash };
+      shared_strings_[slot] = loc;
+      if (++num_shared_strings_ * 2 > shared_strings_.size())
+        GrowHashIndex(&shared_strings_);
+    }
+    return off;
+  }
+
+  Offset<String> CreateSharedString(const char *str) {
+    return CreateSharedString(str, strlen(str));
+  }
+
+  Offset<String> CreateSharedString(const std::string &str) {
+    return CreateSharedString(str.c_str(), str.length());
+  }
+
+  Offset<String> CreateSharedString(const String *str) {
+    return CreateSharedString(str->c_str(), str->Length());
+  }
+
+  // Bounds the memory used by CreateSharedString: at most max_strings
+  // distinct strings are remembered (the index uses 8 bytes per slot, and
+  // has at least twice as many slots as entries). Strings created once the
+  // limit has been reached are still stored, just not shared.
+  // The default is kMaxSharedStrings.
+  static const size_t kMaxSharedStrings = 1 << 20;
+  void SetSharedStringLimit(size_t max_strings) {
+    max_shared_strings_ = max_strings;
+  }
+
   uoffset_t EndVector(size_t len) {
     assert(nested);  // Hit if no corresponding StartVector.
     nested = false;
@@ -814,9 +1317,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
 
   template<typename T> Offset<Vector<T>> CreateVector(const T *v, size_t len) {
     StartVector(len, sizeof(T));
-    for (auto i = len; i > 0; ) {
-      PushElement(v[--i]);
-    }
+    PushElements(v, len, typename std::is_scalar<T>::type());
     return Offset<Vector<T>>(EndVector(len));
   }
 
@@ -824,6 +1325,22 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     return CreateVector(v.data(), v.size());
   }
 
+  // Create a vector of "len" tables of type T, calling "f(i)" to create
+  // table i (e.g. with the generated CreateT() or TBuilder), which must
+  // return its Offset<T>.
+  // Default values are stored within the batch, such that all tables
+  // setting the same fields get an identical layout, and their vtable is only
+  // built once (see EndTable).
+  template<typename T, typename F> Offset<Vector<Offset<T>>>
+      CreateVectorOfTables(size_t len, F f) {
+    auto force_defaults = force_defaults_;
+    force_defaults_ = true;
+    std::vector<Offset<T>> tables(len);
+    for (size_t i = 0; i < len; i++) tables[i] = f(i);
+    force_defaults_ = force_defaults;
+    return CreateVector(tables);
+  }
+
   template<typename T> Offset<Vector<const T *>> CreateVectorOfStructs(
                                                        const T *v, size_t len) {
     StartVector(len * sizeof(T) / AlignOf<T>(), AlignOf<T>());
@@ -838,6 +1355,9 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
 
   template<typename T> Offset<Vector<Offset<T>>> CreateVectorOfSortedTables(
                                                      Offset<T> *v, size_t len) {
+    // Comparing keys may follow offsets across segments, so make the buffer
+    // contiguous first.
+    buf_.data();
     std::sort(v, v + len,
       [this](const Offset<T> &a, const Offset<T> &b) -> bool {
         auto table_a = reinterpret_cast<T *>(buf_.data_at(a.o));
@@ -853,6 +1373,61 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     return CreateVectorOfSortedTables(v->data(), v->size());
   }
 
+  // Create a hash index for a vector of tables with a key, for O(1) lookups
+  // (see Vector::LookupByKey). "v" must be in the order of the vector, e.g.
+  // as sorted by CreateVectorOfSortedTables. Store the result in the field
+  // that has the "hash_index" attribute for the vector.
+  // The index is open addressed, with each slot holding 1 + the index of an
+  // element (0 for empty), and no more than half the slots in use.
+  template<typename T> Offset<Vector<uint32_t>> CreateHashIndex(
+                                                 const Offset<T> *v,
+                                                 size_t len) {
+    // Hashing keys may follow offsets across segments.
+    buf_.data();
+    size_t num_slots = 2;
+    while (num_slots < len * 2) num_slots *= 2;
+    auto mask = num_slots - 1;
+    std::vector<uint32_t> slots(num_slots, 0);
+    for (size_t i = 0; i < len; i++) {
+      auto table = reinterpret_cast<const T *>(buf_.data_at(v[i].o));
+      auto slot = table->KeyHash() & mask;
+      while (slots[slot]) slot = (slot + 1) & mask;
+      slots[slot] = static_cast<uint32_t>(i + 1);
+    }
+    return CreateVector(slots);
+  }
+
+  template<typename T> Offset<Vector<uint32_t>> CreateHashIndex(
+                                              const std::vector<Offset<T>> &v) {
+    return CreateHashIndex(v.data(), v.size());
+  }
+
+  // Create a key index for a vector of tables with a key, for lookups that
+  // touch fewer tables (see Vector::LookupByKey and KeyIndexSize). "v" must
+  // be sorted by key, as done by CreateVectorOfSortedTables. Store the result
+  // in the field that has the "key_index" attribute for the vector.
+  template<typename T> Offset<Vector<uint64_t>> CreateKeyIndex(
+                                                  const Offset<T> *v,
+                                                  size_t len) {
+    // Reading keys may follow offsets across segments.
+    buf_.data();
+    auto size = KeyIndexSize(len);
+    std::vector<uint64_t> sorted(size, 0xFFFFFFFFFFFFFFFFULL);
+    for (size_t i = 0; i < len; i++) {
+      sorted[i] = reinterpret_cast<const T *>(buf_.data_at(v[i].o))->
+                    KeyPrefix();
+    }
+    std::vector<uint64_t> prefixes(size);
+    for (size_t k = 1; k <= size; k++)
+      prefixes[k - 1] = sorted[KeyIndexRank(k, size)];
+    return CreateVector(prefixes);
+  }
+
+  template<typename T> Offset<Vector<uint64_t>> CreateKeyIndex(
+                                              const std::vector<Offset<T>> &v) {
+    return CreateKeyIndex(v.data(), v.size());
+  }
+
   // Specialized version for non-copying use cases. Write the data any time
   // later to the returned buffer pointer `buf`.
   uoffset_t CreateUninitializedVector(size_t len, size_t elemsize,
@@ -869,6 +1444,48 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
                                      reinterpret_cast<uint8_t **>(buf));
   }
 
+  // Copy the finished buffer held by "child" into this one, returning the
+  // offset of its root in this buffer.
+  // All offsets in a FlatBuffer are relative, so this is a plain copy of the
+  // bytes, no matter how large the child buffer is. This allows building
+  // independent parts of a large buffer on multiple threads, each using its
+  // own builder, and then combining them.
+  // Only the root offset is left out; a file identifier, if any, is kept.
+  template<typename T> Offset<T> Splice(const FlatBufferBuilder &child) {
+    NotNested();
+    child.Finished();
+    // Child data is aligned relative to the end of its buffer.
+    Align(child.minalign_);
+    auto size = child.GetSize() - sizeof(uoffset_t);
+    auto dest = buf_.make_space(size) + size;
+    // Copy the segments of the child (usually just one) from its end.
+    for (auto i = child.GetNumSegments(); i > 0; ) {
+      size_t len;
+      auto seg = child.GetSegment(--i, &len);
+      if (!i) {
+        // The first segment holds the root offset.
+        return SplicedRoot<T>(dest - (len - sizeof(uoffset_t)), seg, len);
+      }
+      dest -= len;
+      memcpy(dest, seg, len);
+    }
+    assert(0);
+    return 0;
+  }
+
+  // Same, for a finished buffer "buf" of "len" bytes stored anywhere (e.g.
+  // received over the network). Its data is realigned to "alignment", which
+  // should be at least the largest alignment used in it (note that
+  // ForceVectorAlignment may increase it beyond sizeof(largest_scalar_t)).
+  template<typename T> Offset<T> Splice(const uint8_t *buf, size_t len,
+                                        size_t alignment =
+                                          sizeof(largest_scalar_t)) {
+    NotNested();
+    Align(alignment);
+    auto dest = buf_.make_space(len - sizeof(uoffset_t));
+    return SplicedRoot<T>(dest, buf, len);
+  }
+
   static const size_t kFileIdentifierLength = 4;
 
   // Finish serializing a buffer by writing the root offset.
@@ -876,20 +1493,38 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // FlatBuffers file header.
   template<typename T> void Finish(Offset<T> root,
                                    const char *file_identifier = nullptr) {
+    FinishBuffer(root.o, file_identifier, false);
+  }
+
+  // Like Finish, but also prefixes the buffer with its size (not counting
+  // the prefix itself), such that buffers can be stored one after the other,
+  // e.g. in a log file (see FrameReader in buffer_io.h).
+  // Read it with GetSizePrefixedRoot.
+  template<typename T> void FinishSizePrefixed(
+                                     Offset<T> root,
+                                     const char *file_identifier = nullptr) {
+    FinishBuffer(root.o, file_identifier, true);
+  }
+
+ private:
+  void FinishBuffer(uoffset_t root, const char *file_identifier,
+                    bool size_prefix) {
     NotNested();
     // This will cause the whole buffer to be aligned.
-    PreAlign(sizeof(uoffset_t) + (file_identifier ? kFileIdentifierLength : 0),
+    PreAlign(sizeof(uoffset_t) + (file_identifier ? kFileIdentifierLength : 0)
+             + (size_prefix ? sizeof(uoffset_t) : 0),
              minalign_);
     if (file_identifier) {
       assert(strlen(file_identifier) == kFileIdentifierLength);
       buf_.push(reinterpret_cast<const uint8_t *>(file_identifier),
                 kFileIdentifierLength);
     }
-    PushElement(ReferTo(root.o));  // Location of root.
+    PushElement(ReferTo(root));  // Location of root.
+    if (size_prefix) PushElement(GetSize());
     finished = true;
+    if (size_stats_) RecordSizeStats();
   }
 
- private:
   // You shouldn't really be copying instances of this class.
   FlatBufferBuilder(const FlatBufferBuilder &);
   FlatBufferBuilder &operator=(const FlatBufferBuilder &);
@@ -899,9 +1534,194 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     voffset_t id;
   };
 
-  simple_allocator default_allocator;
+  void ReserveFromSizeStats() {
+    reallocations_at_clear_ = buf_.num_reallocations();
+    capacity_at_clear_ = buf_.capacity();
+    Reserve(size_stats_->Estimate());
+  }
+
+  void RecordSizeStats() {
+    size_stats_->AddSize(GetSize());
+    auto reallocations = buf_.num_reallocations() - reallocations_at_clear_;
+    // Estimate how often the buffer would have grown without reserving.
+    size_t unreserved = 0;
+    for (auto capacity = capacity_at_clear_; capacity < GetSize();
+         capacity += (std::max)(capacity / 2, sizeof(largest_scalar_t)))
+      unreserved++;
+    size_stats_->AddReallocations(reallocations,
+                                  unreserved > reallocations
+                                    ? unreserved - reallocations
+                                    : 0);
+  }
+
+  // Write a vtable for the table being ended, unless an identical one exists
+  // already. Returns the location of the vtable to use.
+  uoffset_t WriteVTable(uoffset_t vtableoffsetloc, uoffset_t table_object_size,
+                        voffset_t numfields) {
+    // Write a vtable, which consists entirely of voffset_t elements.
+    // It starts with the number of offsets, followed by a type id, followed
+    // by the offsets themselves. It is allocated in one go, so it is always
+    // contiguous (even in segmented mode), and needs no padding since the
+    // buffer is already aligned to sizeof(soffset_t).
+    auto vt1_size = FieldIndexToOffset(numfields);
+    auto vt = buf_.make_space(vt1_size);
+    memset(vt, 0, vt1_size);
+    WriteScalar<voffset_t>(vt, vt1_size);
+    WriteScalar<voffset_t>(vt + sizeof(voffset_t),
+                           static_cast<voffset_t>(table_object_size));
+    // Write the offsets into the table, and remember the layout.
+    auto &recent = recent_layouts_[next_recent_layout_];
+    next_recent_layout_ = (next_recent_layout_ + 1) % kNumRecentLayouts;
+    recent.fields.resize(2 + offsetbuf_.size() * 2);
+    recent.fields[0] = numfields;
+    recent.fields[1] = static_cast<voffset_t>(table_object_size);
+    auto layout = recent.fields.begin() + 2;
+    for (auto field_location = offsetbuf_.begin();
+              field_location != offsetbuf_.end();
+            ++field_location) {
+      auto pos = static_cast<voffset_t>(vtableoffsetloc - field_location->off);
+      // If this asserts, it means you've set a field twice.
+      assert(!ReadScalar<voffset_t>(vt + field_location->id));
+      WriteScalar<voffset_t>(vt + field_location->id, pos);
+      *layout++ = field_location->id;
+      *layout++ = pos;
+    }
+    auto vt1 = reinterpret_cast<voffset_t *>(vt);
+    auto vt_use = GetSize();
+    // See if we already have generated a vtable with this exact same
+    // layout before. If so, make it point to the old one, remove this one.
+    auto hash = HashFnv1a<uint32_t>(vt1, vt1_size);
+    auto mask = vtables_.size() - 1;
+    auto slot = hash & mask;
+    for (; vtables_[slot].off; slot = (slot + 1) & mask) {
+      auto &loc = vtables_[slot];
+      if (loc.hash != hash) continue;
+      auto vt2 = reinterpret_cast<voffset_t *>(buf_.data_at(loc.off));
+      auto vt2_size = ReadScalar<voffset_t>(vt2);
+      if (vt1_size != vt2_size || memcmp(vt2, vt1, vt1_size)) continue;
+      vt_use = loc.off;
+      buf_.pop(GetSize() - vtableoffsetloc);
+      break;
+    }
+    // If this is a new vtable, remember it.
+    if (vt_use == GetSize()) {
+      HashedOffset loc = { vt_use, hash };
+      vtables_[slot] = loc;
+      // Keep the load factor at or below 1/2 so probe sequences stay short.
+      if (++num_vtables_ * 2 > vtables_.size()) GrowHashIndex(&vtables_);
+    }
+    recent.vtable = vt_use;
+    return vt_use;
+  }
+
+  // If the fields of the table being ended (in offsetbuf_) are in the same
+  // places as those of a recently written table, returns the vtable of that
+  // table, otherwise 0.
+  uoffset_t FindRecentLayout(uoffset_t vtableoffsetloc,
+                             uoffset_t table_object_size,
+                             voffset_t numfields) const {
+    for (size_t i = 0; i < kNumRecentLayouts; i++) {
+      auto &recent = recent_layouts_[i];
+      if (!recent.vtable ||
+          recent.fields.size() != 2 + offsetbuf_.size() * 2 ||
+          recent.fields[0] != numfields ||
+          recent.fields[1] != table_object_size) continue;
+      auto layout = recent.fields.begin() + 2;
+      auto field_location = offsetbuf_.begin();
+      for (; field_location != offsetbuf_.end();
+           ++field_location, layout += 2) {
+        if (layout[0] != field_location->id ||
+            layout[1] != vtableoffsetloc - field_location->off) break;
+      }
+      if (field_location == offsetbuf_.end()) return recent.vtable;
+    }
+    return 0;
+  }
+
+  // Copies the start of a spliced buffer (up to the root offset, which is
+  // left out) to "dest", the location just written, and returns the offset
+  // of the root.
+  template<typename T> Offset<T> SplicedRoot(uint8_t *dest,
+                                             const uint8_t *buf, size_t len) {
+    assert(len >= sizeof(uoffset_t));
+    memcpy(dest, buf + sizeof(uoffset_t), len - sizeof(uoffset_t));
+    auto root = ReadScalar<uoffset_t>(buf);
+    // dest is at GetSize(), and corresponds to sizeof(uoffset_t) in buf.
+    return Offset<T>(GetSize() - (root - sizeof(uoffset_t)));
+  }
 
-  vector_downward buf_;
+  void TrackMinAlign(size_t elem_size) {
+    if (elem_size > minalign_) minalign_ = elem_size;
+  }
+
+  // Scalar vector elements are written in one go: StartVector() already
+  // aligned the buffer, so no padding is needed between elements.
+  template<typename T> void PushElements(const T *v, size_t len,
+                                         std::true_type) {
+    if (!len) return;
+    TrackMinAlign(sizeof(T));
+    auto dest = buf_.make_space(len * sizeof(T));
+    #if FLATBUFFERS_LITTLEENDIAN
+      memcpy(dest, v, len * sizeof(T));
+    #else
+      // A simple loop, such that the compiler can vectorize the swapping.
+      auto dest_elems = reinterpret_cast<T *>(dest);
+      for (size_t i = 0; i < len; i++) dest_elems[i] = EndianScalar(v[i]);
+    #endif
+  }
+
+  // Offsets are relative to where they are stored (see ReferTo): element i
+  // will end at end - i * sizeof(uoffset_t), counting from the end of the
+  // buffer.
+  template<typename T> void PushElements(const Offset<T> *v, size_t len,
+                                         std::false_type) {
+    if (!len) return;
+    TrackMinAlign(sizeof(uoffset_t));
+    auto end = GetSize() + len * sizeof(uoffset_t);
+    auto dest = buf_.make_space(len * sizeof(uoffset_t));
+    for (size_t i = 0; i < len; i++) {
+      // Offset must refer to something already in buffer.
+      assert(v[i].o && v[i].o <= end - len * sizeof(uoffset_t));
+      WriteScalar(dest + i * sizeof(uoffset_t),
+                  static_cast<uoffset_t>(end - i * sizeof(uoffset_t) -
+                                         v[i].o));
+    }
+  }
+
+  // An entry in the open addressing hash tables of objects written so far
+  // (see vtables_ and shared_strings_ below).
+  // An offset of 0 marks an empty slot (no object can be at offset 0).
+  struct HashedOffset {
+    uoffset_t off;
+    uint32_t hash;
+  };
+
+  // Double the size of a hash index (its size must be a power of 2),
+  // re-inserting existing entries using their stored hash (no need to touch
+  // the buffer).
+  static void GrowHashIndex(std::vector<HashedOffset> *index) {
+    std::vector<HashedOffset> old_index(index->size() * 2);
+    old_index.swap(*index);
+    auto mask = index->size() - 1;
+    for (auto it = old_index.begin(); it != old_index.end(); ++it) {
+      if (!it->off) continue;
+      auto slot = it->hash & mask;
+      while ((*index)[slot].off) slot = (slot + 1) & mask;
+      (*index)[slot] = *it;
+    }
+  }
+
+  static void ClearHashIndex(std::vector<HashedOffset> *index,
+                             size_t *num_entries) {
+    if (!*num_entries) return;
+    HashedOffset empty = { 0, 0 };
+    std::fill(index->begin(), index->end(), empty);
+    *num_entries = 0;
+  }
+
+  // Mutable since joining segments (see SetSegmented) doesn't change the
+  // contents.
+  mutable vector_downward buf_;
 
   // Accumulating offsets of table members while it is being built.
   std::vector<FieldLoc> offsetbuf_;
@@ -912,11 +1732,38 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // Ensure the buffer is finished before it is being accessed.
   bool finished;
 
-  std::vector<uoffset_t> vtables_;  // todo: Could make this into a map?
+  // Hash index of all vtables in the buffer, used to share vtables between
+  // tables with the same layout.
+  std::vector<HashedOffset> vtables_;
+  size_t num_vtables_;
+
+  // The layouts of the most recently written tables, and the vtable each
+  // uses (0 if unused). A layout is numfields, object size, then the id and
+  // position of each field, in the order they were added.
+  // More than one is kept since tables with 8-byte fields, when interleaved
+  // with other objects, typically alternate between two paddings.
+  struct TableLayout {
+    TableLayout() : vtable(0) {}
+    uoffset_t vtable;
+    std::vector<voffset_t> fields;
+  };
+  static const size_t kNumRecentLayouts = 2;
+  TableLayout recent_layouts_[kNumRecentLayouts];
+  size_t next_recent_layout_;
+
+  // Hash index of strings created with CreateSharedString(). Empty until
+  // the first call, and never holds more than max_shared_strings_ entries.
+  std::vector<HashedOffset> shared_strings_;
+  size_t num_shared_strings_;
+  size_t max_shared_strings_;
 
   size_t minalign_;
 
   bool force_defaults_;  // Serialize values equal to their defaults anyway.
+
+  BufferSizeStats *size_stats_;
+  size_t reallocations_at_clear_;
+  size_t capacity_at_clear_;
 };
 
 // Helpers to get a typed pointer to the root object contained in the buffer.
@@ -930,6 +1777,17 @@ template<typename T> const T *GetRoot(const void *buf) {
   return GetMutableRoot<T>(const_cast<void *>(buf));
 }
 
+// The same, for buffers finished with FinishSizePrefixed.
+template<typename T> const T *GetSizePrefixedRoot(const void *buf) {
+  return GetRoot<T>(reinterpret_cast<const uint8_t *>(buf) + sizeof(uoffset_t));
+}
+
+// The size of a buffer finished with FinishSizePrefixed, not counting the
+// size prefix itself.
+inline uoffset_t GetPrefixedSize(const void *buf) {
+  return ReadScalar<uoffset_t>(buf);
+}
+
 // Helper to see if the identifier in a buffer has the expected value.
 inline bool BufferHasIdentifier(const void *buf, const char *identifier) {
   return strncmp(reinterpret_cast<const char *>(buf) + sizeof(uoffset_t),
@@ -937,25 +1795,94 @@ inline bool BufferHasIdentifier(const void *buf, const char *identifier) {
 }
 
 // Helper class to verify the integrity of a FlatBuffer
+// Define FLATBUFFERS_VERIFIER_STATS to have it record why verification failed,
+// and how much work it did (see GetStats()). Without it, none of this is
+// tracked.
 class Verifier FLATBUFFERS_FINAL_CLASS {
  public:
   Verifier(const uint8_t *buf, size_t buf_len, size_t _max_depth = 64,
            size_t _max_tables = 1000000)
     : buf_(buf), end_(buf + buf_len), depth_(0), max_depth_(_max_depth),
       num_tables_(0), max_tables_(_max_tables)
+      #ifdef FLATBUFFERS_VERIFIER_STATS
+        , table_(nullptr), field_(0)
+      #endif
     {}
 
+  // Kinds of verification failures.
+  enum Failure {
+    kNoFailure,
+    kOutOfBounds,           // Data extends outside of the buffer.
+    kStringNotTerminated,   // String without 0 terminator.
+    kRequiredFieldMissing,
+    kTooDeep,               // Tables nested deeper than max_depth.
+    kTooManyTables,         // More than max_tables tables.
+    kOther
+  };
+
+  #ifdef FLATBUFFERS_VERIFIER_STATS
+  struct Stats {
+    Stats() : failure(kNoFailure), failure_offset(0), failure_table(-1),
+              failure_field(0), bytes_verified(0), max_depth(0) {}
+    // The first failure, if any.
+    Failure failure;
+    // Offset from the start of the buffer of the data that failed to verify,
+    // and of the table being verified (-1 if none).
+    ptrdiff_t failure_offset;
+    ptrdiff_t failure_table;
+    // The field of that table being verified (its vtable offset, see
+    // FieldIndexToOffset), or 0.
+    voffset_t failure_field;
+    // Work done: bytes checked to be within the buffer (some may be counted
+    // more than once), and maximum table nesting depth reached.
+    size_t bytes_verified;
+    size_t max_depth;
+  };
+
+  const Stats &GetStats() const { return stats_; }
+  #endif
+
   // Central location where any verification failures register.
-  bool Check(bool ok) const {
+  bool Check(bool ok, Failure failure = kOther,
+             const void *elem = nullptr) const {
     #ifdef FLATBUFFERS_DEBUG_VERIFICATION_FAILURE
       assert(ok);
     #endif
+    #ifdef FLATBUFFERS_VERIFIER_STATS
+      if (!ok && stats_.failure == kNoFailure) {
+        stats_.failure = failure;
+        stats_.failure_offset = elem
+          ? reinterpret_cast<const uint8_t *>(elem) - buf_
+          : 0;
+        stats_.failure_table = table_ ? table_ - buf_ : -1;
+        stats_.failure_field = field_;
+      }
+    #else
+      (void)failure;
+      (void)elem;
+    #endif
     return ok;
   }
 
+  // Called by tables being verified, to track which field is being verified
+  // (see Stats).
+  void SetContext(const uint8_t *table, voffset_t field) const {
+    #ifdef FLATBUFFERS_VERIFIER_STATS
+      table_ = table;
+      field_ = field;
+    #else
+      (void)table;
+      (void)field;
+    #endif
+  }
+
   // Verify any range within the buffer.
   bool Verify(const void *elem, size_t elem_len) const {
-    return Check(elem_len <= (size_t) (end_ - buf_) && elem >= buf_ && elem <= end_ - elem_len);
+    #ifdef FLATBUFFERS_VERIFIER_STATS
+      stats_.bytes_verified += elem_len;
+    #endif
+    return Check(elem_len <= (size_t) (end_ - buf_) && elem >= buf_ &&
+                 elem <= end_ - elem_len, kOutOfBounds, elem);
   }
 
   // Verify a range indicated by sizeof(T).
@@ -987,7 +1914,8 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
     return !str ||
            (VerifyVector(reinterpret_cast<const uint8_t *>(str), 1, &end) &&
             Verify(end, 1) &&      // Must have terminator
-            Check(*end == '\0'));  // Terminating byte must be 0.
+            // Terminating byte must be 0.
+            Check(*end == '\0', kStringNotTerminated, end));
   }
 
   // Common code between vectors and strings.
@@ -1023,6 +1951,14 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
     return true;
   }
 
+  // The root table of the buffer, for use with the bounds-checked accessors
+  // (see Table::GetFieldChecked), or NULL if the buffer is too small.
+  template<typename T> const T *GetRootChecked() const {
+    return Verify<uoffset_t>(buf_)
+      ? reinterpret_cast<const T *>(buf_ + ReadScalar<uoffset_t>(buf_))
+      : nullptr;
+  }
+
   // Verify this whole buffer, starting with root type T.
   template<typename T> bool VerifyBuffer() {
     // Call T::Verify, which must be in the generated code for this type.
@@ -1038,9 +1974,16 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   bool VerifyComplexity() {
     depth_++;
     num_tables_++;
-    return Check(depth_ <= max_depth_ && num_tables_ <= max_tables_);
+    #ifdef FLATBUFFERS_VERIFIER_STATS
+      stats_.max_depth = (std::max)(stats_.max_depth, depth_);
+    #endif
+    return Check(depth_ <= max_depth_, kTooDeep) &&
+           Check(num_tables_ <= max_tables_, kTooManyTables);
   }
 
+  // The number of tables verified so far.
+  size_t GetNumTables() const { return num_tables_; }
+
   // Called at the end of a table to pop the depth count.
   bool EndTable() {
     depth_--;
@@ -1054,6 +1997,12 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   size_t max_depth_;
   size_t num_tables_;
   size_t max_tables_;
+  #ifdef FLATBUFFERS_VERIFIER_STATS
+    mutable Stats stats_;
+    // The table and field being verified.
+    mutable const uint8_t *table_;
+    mutable voffset_t field_;
+  #endif
 };
 
 // "structs" are flat structures that do not have an offset table, thus
@@ -1151,6 +2100,7 @@ class Table {
   // Verify the vtable of this table.
   // Call this once per table, followed by VerifyField once per field.
   bool VerifyTableStart(Verifier &verifier) const {
+    verifier.SetContext(data_, 0);
     // Check the vtable offset.
     if (!verifier.Verify<soffset_t>(data_)) return false;
     auto vtable = data_ - ReadScalar<soffset_t>(data_);
@@ -1165,6 +2115,7 @@ class Table {
                                         voffset_t field) const {
     // Calling GetOptionalFieldOffset should be safe now thanks to
     // VerifyTable().
+    verifier.SetContext(data_, field);
     auto field_offset = GetOptionalFieldOffset(field);
     // Check the actual field.
     return !field_offset || verifier.Verify<T>(data_ + field_offset);
@@ -1173,12 +2124,75 @@ class Table {
   // VerifyField for required fields.
   template<typename T> bool VerifyFieldRequired(const Verifier &verifier,
                                         voffset_t field) const {
+    verifier.SetContext(data_, field);
     auto field_offset = GetOptionalFieldOffset(field);
-    return verifier.Check(field_offset != 0) &&
+    return verifier.Check(field_offset != 0,
+                          Verifier::kRequiredFieldMissing, data_) &&
            verifier.Verify<T>(data_ + field_offset);
   }
 
+  // Bounds-checked versions of the accessors above, for reading buffers that
+  // haven't been verified as a whole (see flatc --gen-bounds-checked): only
+  // the fields actually read, and what they point to, get checked against
+  // the buffer of "verifier". Fields that fail the check read as absent.
+
+  // Like GetOptionalFieldOffset, also checking the field has "size" bytes.
+  voffset_t GetCheckedFieldOffset(const Verifier &verifier, voffset_t field,
+                                  size_t size) const {
+    if (!verifier.Verify<soffset_t>(data_)) return 0;
+    auto vtable = data_ - ReadScalar<soffset_t>(data_);
+    if (!verifier.Verify<voffset_t>(vtable) ||
+        field >= ReadScalar<voffset_t>(vtable) ||
+        !verifier.Verify<voffset_t>(vtable + field)) return 0;
+    auto field_offset = ReadScalar<voffset_t>(vtable + field);
+    return field_offset && verifier.Verify(data_ + field_offset, size)
+      ? field_offset
+      : 0;
+  }
+
+  template<typename T> T GetFieldChecked(const Verifier &verifier,
+                                         voffset_t field, T defaultval) const {
+    auto field_offset = GetCheckedFieldOffset(verifier, field, sizeof(T));
+    return field_offset ? ReadScalar<T>(data_ + field_offset) : defaultval;
+  }
+
+  template<typename P> P GetPointerChecked(const Verifier &verifier,
+                                           voffset_t field) const {
+    auto field_offset = GetCheckedFieldOffset(verifier, field,
+                                              sizeof(uoffset_t));
+    if (!field_offset) return nullptr;
+    auto p = data_ + field_offset;
+    auto target = reinterpret_cast<P>(p + ReadScalar<uoffset_t>(p));
+    return VerifyTarget(verifier, target) ? target : nullptr;
+  }
+
+  template<typename P> P GetStructChecked(const Verifier &verifier,
+                                          voffset_t field) const {
+    auto field_offset = GetCheckedFieldOffset(
+                          verifier, field,
+                          sizeof(typename std::remove_pointer<P>::type));
+    return field_offset ? reinterpret_cast<P>(data_ + field_offset) : nullptr;
+  }
+
  private:
+  // What GetPointerChecked checks before handing out a pointer: all of a
+  // string or vector (whose elements are accessed without checks), but just
+  // the start of a table or union, whose fields are checked as they are read.
+  static bool VerifyTarget(const Verifier &verifier, const void *table) {
+    return verifier.Verify<soffset_t>(table);
+  }
+  static bool VerifyTarget(const Verifier &verifier, const String *str) {
+    return verifier.Verify(str);
+  }
+  template<typename T> static bool VerifyTarget(const Verifier &verifier,
+                                                const Vector<T> *vec) {
+    return verifier.Verify(vec);
+  }
+  static bool VerifyTarget(const Verifier &verifier,
+                           const Vector<Offset<String>> *vec) {
+    return verifier.Verify(vec) && verifier.VerifyVectorOfStrings(vec);
+  }
+
   // private constructor & copy constructor: you obtain instances of this
   // class by pointing to existing data only
   Table();
@@ -1187,6 +2201,55 @@ class Table {
   uint8_t data_[1];
 };
 
+// Helper for ForEachPrefetched, for tables (strings have no vtable).
+template<typename T> void PrefetchVTable(const T *, std::false_type) {}
+template<typename T> void PrefetchVTable(const T *table, std::true_type) {
+  auto p = reinterpret_cast<const uint8_t *>(table);
+  FLATBUFFERS_PREFETCH(p - ReadScalar<soffset_t>(p));
+}
+
+// Calls f(element) for each element of a vector of tables or strings, in
+// order, while prefetching the element "distance" places ahead (and for
+// tables, the vtable of the element half that far ahead, by which time its
+// vtable offset should be in cache). When elements are scattered across a
+// buffer larger than the CPU caches, this hides much of the latency of
+// reaching them.
+template<typename T, typename F> void ForEachPrefetched(
+                                        const Vector<Offset<T>> &vec, F f,
+                                        uoffset_t distance = 16) {
+  auto size = vec.size();
+  auto vtable_distance = distance / 2;
+  for (uoffset_t i = 0; i < size; i++) {
+    if (i + distance < size) FLATBUFFERS_PREFETCH(vec.Get(i + distance));
+    if (i + vtable_distance < size)
+      PrefetchVTable(vec.Get(i + vtable_distance),
+                     typename std::is_base_of<Table, T>::type());
+    f(vec.Get(i));
+  }
+}
+
+// Reads scalar field "field" (e.g. Monster::VT_HP) of each table in "vec"
+// into out[0 .. vec.size()), with "defaultval" for tables that lack it.
+// Tables typically share vtables (see FlatBufferBuilder::EndTable), so the
+// field offset is only looked up again when the vtable changes, leaving one
+// read of the vtable offset and one of the field per table.
+template<typename T, typename U> void GatherField(const Vector<Offset<U>> &vec,
+                                                  voffset_t field,
+                                                  T defaultval, T *out) {
+  const uint8_t *last_vtable = nullptr;
+  voffset_t field_offset = 0;
+  for (uoffset_t i = 0; i < vec.size(); i++) {
+    auto table = reinterpret_cast<const uint8_t *>(vec.Get(i));
+    auto vtable = table - ReadScalar<soffset_t>(table);
+    if (vtable != last_vtable) {
+      field_offset = reinterpret_cast<const Table *>(table)->
+                       GetOptionalFieldOffset(field);
+      last_vtable = vtable;
+    }
+    out[i] = field_offset ? ReadScalar<T>(table + field_offset) : defaultval;
+  }
+}
+
 // Utility function for reverse lookups on the EnumNames*() functions
 // (in the generated C++ code)
 // names must be NULL terminated.
@@ -60,6 +60,18 @@ T HashFnv1a(const char *input) {
   return hash;
 }
 
+// Same, hashing "len" bytes of "input".
+template <typename T>
+T HashFnv1a(const void *input, size_t len) {
+  T hash = FnvTraits<T>::kOffsetBasis;
+  auto bytes = reinterpret_cast<const unsigned char *>(input);
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= bytes[i];
+    hash *= FnvTraits<T>::kFnvPrime;
+  }
+  return hash;
+}
+
 template <typename T>
 struct NamedHashFunction {
   const char *name;
@@ -310,6 +310,8 @@ class Parser {
  public:
   Parser(bool strict_json = false, bool proto_mode = false)
     : root_struct_def_(nullptr),
+      binary_(nullptr),
+      binary_size_(0),
       source_(nullptr),
       cursor_(nullptr),
       line_(1),
@@ -327,6 +329,8 @@ class Parser {
     known_attributes_.insert("bit_flags");
     known_attributes_.insert("original_order");
     known_attributes_.insert("nested_flatbuffer");
+    known_attributes_.insert("hash_index");
+    known_attributes_.insert("key_index");
   }
 
   ~Parser() {
@@ -362,6 +366,23 @@ class Parser {
   // See reflection/reflection.fbs
   void Serialize();
 
+  // Have the text and binary generators output "buf" rather than the
+  // FlatBuffer in builder_, until the next call to Parse() or Serialize().
+  // "buf" isn't copied, so must stay valid until then (flatc uses this to
+  // output binary files it has mapped into memory).
+  void SetBinary(const uint8_t *buf, size_t size) {
+    binary_ = buf;
+    binary_size_ = size;
+  }
+
+  // The FlatBuffer to output: the one given to SetBinary(), or else builder_.
+  const uint8_t *GetBinary() const {
+    return binary_ ? binary_ : builder_.GetBufferPointer();
+  }
+  size_t GetBinarySize() const {
+    return binary_ ? binary_size_ : builder_.GetSize();
+  }
+
  private:
   int64_t ParseHexNum(int nibbles);
   void Next();
@@ -416,6 +437,9 @@ class Parser {
   std::map<std::string, std::set<std::string>> files_included_per_file_;
 
  private:
+  const uint8_t *binary_;  // See SetBinary().
+  size_t binary_size_;
+
   const char *source_, *cursor_;
   int line_;  // the current line being parsed
   int token_;
@@ -454,6 +478,7 @@ struct GeneratorOptions {
   bool scoped_enums;
   bool include_dependence_headers;
   bool mutable_buffer;
+  bool bounds_checked;
   bool one_file;
 
   // Possible options for the more general generator below.
@@ -468,6 +493,7 @@ struct GeneratorOptions {
                        output_enum_identifiers(true), prefixed_enums(true), scoped_enums(false),
                        include_dependence_headers(true),
                        mutable_buffer(false),
+                       bounds_checked(false),
                        one_file(false),
                        lang(GeneratorOptions::kJava) {}
 };
@@ -22,6 +22,10 @@
 // Should normally not be a problem since it can be generated by the
 // previous version of flatc whenever this code needs to change.
 // See reflection/generate_code.sh
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 #include "flatbuffers/reflection_generated.h"
 
 // Helper functionality for reflection.
@@ -305,6 +309,98 @@ inline void SetAnyVectorElemS(VectorOfAny *vec, reflection::BaseType elem_type,
 }
 
 
+// ------------------------- FIELD HANDLES -------------------------
+
+class SchemaIndex;
+
+// A field resolved once from its reflection::Field, for when you access the
+// same field in many tables or structs. Does the same as GetAnyFieldI and
+// friends, but rather than switching on the type of the field on each
+// access, calls a reader or writer for its type that was picked up front.
+class FieldHandle {
+ public:
+  // Pass the schema if you want fields of table type pretty-printed by GetS.
+  explicit FieldHandle(const reflection::Field &field,
+                       const reflection::Schema *schema = nullptr);
+  // Same, with the schema of "index".
+  FieldHandle(const reflection::Field &field, const SchemaIndex &index);
+
+  voffset_t offset() const { return offset_; }
+
+  // Same as GetAnyFieldI etc.
+  int64_t GetI(const Table &table) const {
+    auto field_ptr = table.GetAddressOf(offset_);
+    return field_ptr ? get_i_(field_ptr) : default_i_;
+  }
+  double GetF(const Table &table) const {
+    auto field_ptr = table.GetAddressOf(offset_);
+    return field_ptr ? get_f_(field_ptr) : default_f_;
+  }
+  std::string GetS(const Table &table) const {
+    auto field_ptr = table.GetAddressOf(offset_);
+    return field_ptr ? GetS(field_ptr) : "";
+  }
+  int64_t GetI(const Struct &st) const {
+    return get_i_(st.GetAddressOf(offset_));
+  }
+  double GetF(const Struct &st) const {
+    return get_f_(st.GetAddressOf(offset_));
+  }
+  std::string GetS(const Struct &st) const {
+    return GetS(st.GetAddressOf(offset_));
+  }
+
+  // Same as SetAnyFieldI etc.
+  bool SetI(Table *table, int64_t val) const {
+    auto field_ptr = table->GetAddressOf(offset_);
+    if (!field_ptr) return false;
+    set_i_(field_ptr, val);
+    return true;
+  }
+  bool SetF(Table *table, double val) const {
+    auto field_ptr = table->GetAddressOf(offset_);
+    if (!field_ptr) return false;
+    set_f_(field_ptr, val);
+    return true;
+  }
+  bool SetS(Table *table, const char *val) const {
+    auto field_ptr = table->GetAddressOf(offset_);
+    if (!field_ptr) return false;
+    SetS(field_ptr, val);
+    return true;
+  }
+  void SetI(Struct *st, int64_t val) const {
+    set_i_(st->GetAddressOf(offset_), val);
+  }
+  void SetF(Struct *st, double val) const {
+    set_f_(st->GetAddressOf(offset_), val);
+  }
+  void SetS(Struct *st, const char *val) const {
+    SetS(st->GetAddressOf(offset_), val);
+  }
+
+ private:
+  std::string GetS(const uint8_t *data) const {
+    return get_s_ ? get_s_(data)
+                  : GetAnyValueS(base_type_, data, schema_, type_index_);
+  }
+  void SetS(uint8_t *data, const char *val) const;
+  void Init(const reflection::Field &field, const reflection::Schema *schema);
+
+  voffset_t offset_;
+  reflection::BaseType base_type_;
+  int type_index_;
+  const reflection::Schema *schema_;
+  int64_t default_i_;
+  double default_f_;
+  int64_t (*get_i_)(const uint8_t *data);
+  double (*get_f_)(const uint8_t *data);
+  std::string (*get_s_)(const uint8_t *data);  // nullptr for non-scalars.
+  void (*set_i_)(uint8_t *data, int64_t val);
+  void (*set_f_)(uint8_t *data, double val);
+};
+
+
 // ------------------------- RESIZING SETTERS -------------------------
 
 // "smart" pointer for use with resizing vectors: turns a pointer inside
@@ -349,35 +445,168 @@ inline const reflection::Object &GetUnionType(
   return *enumval->object();
 }
 
+// An index over a schema, to look up objects and fields by name with a hash
+// table rather than a binary search over strings, and union types without
+// any searching at all. Build one after loading a schema, for code that does
+// many such lookups, and pass it to the functions below that take one.
+// The schema must outlive the index. The index isn't modified after it is
+// built, so may be shared between threads.
+class SchemaIndex {
+ public:
+  explicit SchemaIndex(const reflection::Schema &schema);
+
+  const reflection::Schema &schema() const { return schema_; }
+
+  // Find a table or struct by name, or nullptr if there isn't one.
+  const reflection::Object *LookupObject(const char *name) const {
+    return Lookup(objects_, nullptr, name);
+  }
+
+  // The position of "objectdef" in the schema's objects (as used for the
+  // index of a reflection::Type), or -1 if it isn't from this schema.
+  int GetObjectIndex(const reflection::Object &objectdef) const {
+    auto it = object_indices_.find(&objectdef);
+    return it == object_indices_.end() ? -1 : it->second;
+  }
+
+  // Find a field of "objectdef" by name, or nullptr if there isn't one.
+  const reflection::Field *LookupField(const reflection::Object &objectdef,
+                                       const char *name) const {
+    return Lookup(fields_, &objectdef, name);
+  }
+
+  // The type field that goes with a union field, or nullptr if "unionfield"
+  // isn't a union.
+  const reflection::Field *GetUnionTypeField(
+      const reflection::Field &unionfield) const {
+    auto it = unions_.find(&unionfield);
+    return it == unions_.end() ? nullptr : it->second.type_field;
+  }
+
+  // Same as GetUnionType above.
+  const reflection::Object &GetUnionType(const reflection::Field &unionfield,
+                                         const Table &table) const {
+    auto it = unions_.find(&unionfield);
+    assert(it != unions_.end());
+    auto &info = it->second;
+    auto union_type = GetFieldI<uint8_t>(table, *info.type_field);
+    assert(union_type < info.num_types);
+    auto object_index = union_types_[info.first + union_type];
+    assert(object_index >= 0);
+    return *schema_.objects()->Get(static_cast<uoffset_t>(object_index));
+  }
+
+  // Same as GetTypeSizeInline above.
+  size_t GetTypeSizeInline(reflection::BaseType base_type,
+                           int type_index) const {
+    return base_type == reflection::Obj ? inline_sizes_[type_index]
+                                        : GetTypeSize(base_type);
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  SchemaIndex(const SchemaIndex &);
+  SchemaIndex &operator=(const SchemaIndex &);
+
+  // Uses the union types below as they are, rather than looking them up.
+  friend class TableCopier;
+
+  // An entry in one of the hash tables, found by the hash of the name of
+  // "def" and its parent (if any). Empty if "def" is nullptr.
+  template<typename T> struct Slot {
+    uint32_t hash;
+    const reflection::Object *parent;
+    const T *def;
+  };
+
+  static uint32_t Hash(const reflection::Object *parent, const char *name) {
+    auto hash = HashFnv1a<uint32_t>(name) ^
+                static_cast<uint32_t>(reinterpret_cast<size_t>(parent) >> 2);
+    // Mix in the parent, since names are often the same for many objects.
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+    return hash;
+  }
+
+  template<typename T> static void Insert(std::vector<Slot<T>> *slots,
+                                          const reflection::Object *parent,
+                                          const T *def) {
+    auto mask = slots->size() - 1;
+    auto hash = Hash(parent, def->name()->c_str());
+    auto i = hash & mask;
+    while ((*slots)[i].def) i = (i + 1) & mask;
+    Slot<T> slot = { hash, parent, def };
+    (*slots)[i] = slot;
+  }
+
+  template<typename T> static const T *Lookup(
+      const std::vector<Slot<T>> &slots, const reflection::Object *parent,
+      const char *name) {
+    auto mask = slots.size() - 1;
+    auto hash = Hash(parent, name);
+    for (auto i = hash & mask; slots[i].def; i = (i + 1) & mask) {
+      auto &slot = slots[i];
+      if (slot.hash == hash && slot.parent == parent &&
+          !strcmp(slot.def->name()->c_str(), name))
+        return slot.def;
+    }
+    return nullptr;
+  }
+
+  struct UnionInfo {
+    const reflection::Field *type_field;
+    size_t first;      // Object for each union type, in union_types_.
+    size_t num_types;
+  };
+
+  const reflection::Schema &schema_;
+  // Open addressing hash tables, a power of 2 in size, at most half full.
+  std::vector<Slot<reflection::Object>> objects_;
+  std::vector<Slot<reflection::Field>> fields_;
+  std::unordered_map<const reflection::Object *, int> object_indices_;
+  std::unordered_map<const reflection::Field *, UnionInfo> unions_;
+  // Object indices, or -1 for union types without one (NONE).
+  std::vector<int> union_types_;
+  // Size of each object when stored inline: bytesize for structs, and the
+  // size of an offset for tables.
+  std::vector<size_t> inline_sizes_;
+};
+
 // Changes the contents of a string inside a FlatBuffer. FlatBuffer must
 // live inside a std::vector so we can resize the buffer if needed.
 // "str" must live inside "flatbuf" and may be invalidated after this call.
 // If your FlatBuffer's root table is not the schema's root table, you should
 // pass in your root_table type as well.
+// "index" is optional, and speeds up finding union types.
 void SetString(const reflection::Schema &schema, const std::string &val,
                const String *str, std::vector<uint8_t> *flatbuf,
-               const reflection::Object *root_table = nullptr);
+               const reflection::Object *root_table = nullptr,
+               const SchemaIndex *index = nullptr);
 
 // Resizes a flatbuffers::Vector inside a FlatBuffer. FlatBuffer must
 // live inside a std::vector so we can resize the buffer if needed.
 // "vec" must live inside "flatbuf" and may be invalidated after this call.
 // If your FlatBuffer's root table is not the schema's root table, you should
 // pass in your root_table type as well.
+// "index" is optional, and speeds up finding union types.
 uint8_t *ResizeAnyVector(const reflection::Schema &schema, uoffset_t newsize,
                          const VectorOfAny *vec, uoffset_t num_elems,
                          uoffset_t elem_size, std::vector<uint8_t> *flatbuf,
-                         const reflection::Object *root_table = nullptr);
+                         const reflection::Object *root_table = nullptr,
+                         const SchemaIndex *index = nullptr);
 
 template <typename T>
 void ResizeVector(const reflection::Schema &schema, uoffset_t newsize, T val,
                   const Vector<T> *vec, std::vector<uint8_t> *flatbuf,
-                  const reflection::Object *root_table = nullptr) {
+                  const reflection::Object *root_table = nullptr,
+                  const SchemaIndex *index = nullptr) {
   auto delta_elem = static_cast<int>(newsize) - static_cast<int>(vec->size());
   auto newelems = ResizeAnyVector(schema, newsize,
                                   reinterpret_cast<const VectorOfAny *>(vec),
                                   vec->size(),
                                   static_cast<uoffset_t>(sizeof(T)), flatbuf,
-                                  root_table);
+                                  root_table, index);
   // Set new elements to "val".
   for (int i = 0; i < delta_elem; i++) {
     auto loc = newelems + i * sizeof(T);
@@ -390,6 +619,104 @@ void ResizeVector(const reflection::Schema &schema, uoffset_t newsize, T val,
   }
 }
 
+// Queues any number of string and vector edits to a FlatBuffer, and applies
+// them all at once in Commit(). Each SetString or ResizeVector call above
+// has to fix up all offsets in the buffer and move all bytes after the
+// edit, so for many edits this is much faster: Commit() does both just once.
+// The buffer isn't touched until Commit(), so pointers into it (such as the
+// "str" and "vec" arguments below) stay valid until then, but not after.
+// If your FlatBuffer's root table is not the schema's root table, you should
+// pass in your root_table type as well.
+// "index" is optional, and speeds up finding union types.
+class MutationTransaction {
+ public:
+  MutationTransaction(const reflection::Schema &schema,
+                      std::vector<uint8_t> *flatbuf,
+                      const reflection::Object *root_table = nullptr,
+                      const SchemaIndex *index = nullptr)
+    : schema_(schema),
+      root_table_(root_table ? *root_table : *schema.root_table()),
+      index_(index), buf_(*flatbuf) {}
+
+  // Changes the contents of string "str".
+  // Queuing another edit of the same string or vector replaces this one.
+  void SetString(const String *str, const std::string &val);
+
+  // Resizes "vec", which has "num_elems" elements of "elem_size" bytes, to
+  // "newsize" elements. Any new elements are copied from "newelems" if given,
+  // or set to 0 otherwise.
+  void ResizeVector(const VectorOfAny *vec, uoffset_t num_elems,
+                    uoffset_t elem_size, uoffset_t newsize,
+                    const uint8_t *newelems = nullptr);
+
+  // Same, setting any new elements to "val".
+  template<typename T> void ResizeVector(const Vector<T> *vec,
+                                         uoffset_t newsize, T val) {
+    auto num_elems = vec->size();
+    std::vector<uint8_t> newelems;
+    for (auto i = num_elems; i < newsize; i++) {
+      newelems.resize(newelems.size() + sizeof(T));
+      auto loc = newelems.data() + newelems.size() - sizeof(T);
+      auto is_scalar = std::is_scalar<T>::value;
+      if (is_scalar) {
+        WriteScalar(loc, val);
+      } else {  // struct
+        *reinterpret_cast<T *>(loc) = val;
+      }
+    }
+    ResizeVector(reinterpret_cast<const VectorOfAny *>(vec), num_elems,
+                 static_cast<uoffset_t>(sizeof(T)), newsize, newelems.data());
+  }
+
+  // The number of edits queued.
+  size_t size() const { return edits_.size(); }
+
+  // Applies all queued edits, with a single pass over the offsets in the
+  // buffer and a single pass copying its bytes.
+  void Commit();
+
+  // Maps an offset into the buffer from before the last Commit() to where
+  // the same data is after it.
+  uoffset_t Remap(uoffset_t offset) const {
+    return static_cast<uoffset_t>(offset + Shift(offset));
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  MutationTransaction(const MutationTransaction &);
+  MutationTransaction &operator=(const MutationTransaction &);
+
+  // Replaces the data of a string or vector. All positions are offsets into
+  // the buffer before the commit.
+  struct Edit {
+    uoffset_t obj;     // The string or vector.
+    uoffset_t end;     // The end of its data, where bytes are added/removed.
+    int delta;         // Bytes added (or removed if negative), aligned.
+    uoffset_t length;  // The new length field.
+    uoffset_t keep;    // Bytes of the old data kept.
+    std::vector<uint8_t> data;  // New data following the kept data.
+  };
+
+  void AddEdit(const void *obj, uoffset_t old_bytes, uoffset_t new_bytes,
+               uoffset_t length, uoffset_t keep, std::vector<uint8_t> *data);
+  int Shift(uoffset_t pos) const;
+  uoffset_t FixOffset(uoffset_t loc);
+  void FixTable(const reflection::Object &objectdef, uoffset_t table);
+  void FixVector(const reflection::Object *elemobjectdef, uoffset_t vec);
+  bool Visit(uoffset_t pos);
+
+  const reflection::Schema &schema_;
+  const reflection::Object &root_table_;
+  const SchemaIndex *index_;
+  std::vector<uint8_t> &buf_;
+  std::vector<Edit> edits_;
+  // Where the edits of the last commit end, and the sum of all deltas up to
+  // and including each one.
+  std::vector<uoffset_t> ends_;
+  std::vector<int> shifts_;
+  std::vector<bool> visited_;  // Tables and vectors, by uoffset_t index.
+};
+
 // Adds any new data (in the form of a new FlatBuffer) to an existing
 // FlatBuffer. This can be used when any of the above methods are not
 // sufficient, in particular for adding new tables and new fields.
@@ -416,11 +743,213 @@ inline bool SetFieldT(Table *table, const reflection::Field &field,
 // to remove.
 // Note: this does not deal with DAGs correctly. If the table passed forms a
 // DAG, the copy will be a tree instead (with duplicates).
+// "index" is optional, and speeds up finding union types.
 
 Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
                                 const reflection::Schema &schema,
                                 const reflection::Object &objectdef,
-                                const Table &table);
+                                const Table &table,
+                                const SchemaIndex *index = nullptr);
+
+// Does the same as CopyTable, but much faster when copying many tables:
+// all tables in the schema are compiled up front into a list of operations,
+// one per field, with sizes, alignment and subobjects all resolved, so
+// copying doesn't need to look at the schema at all, and doesn't allocate
+// (other than in the builder).
+// Create one per schema, and reuse it. Copying modifies scratch space, so
+// use a separate one for each thread.
+class TableCopier {
+ public:
+  // "index" is optional: without one, the copier builds its own. If given,
+  // it must outlive the copier, and may be shared with other copiers.
+  explicit TableCopier(const reflection::Schema &schema,
+                       const SchemaIndex *index = nullptr);
+
+  // "objectdef" must be a table from the schema.
+  Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
+                                  const reflection::Object &objectdef,
+                                  const Table &table) {
+    auto plan = index_->GetObjectIndex(objectdef);
+    assert(plan >= 0 && !objectdef.is_struct());
+    return Copy(fbb, static_cast<uoffset_t>(plan), table);
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  TableCopier(const TableCopier &);
+  TableCopier &operator=(const TableCopier &);
+
+  // How to copy a single field.
+  struct CopyOp {
+    enum Kind {
+      kInline,  // Scalars and structs, copied as "size" bytes.
+      // Everything from here on is stored as an offset, and created before
+      // the table itself.
+      kString,
+      kTable,           // "target" is the plan of the table.
+      kUnion,           // "target" is the first of "size" plans in the
+                        // index's union types.
+      kVectorOfStrings,
+      kVectorOfTables,  // "target" is the plan of the tables.
+      kVectorInline     // Scalars and structs, of "size" bytes each, and
+                        // aligned to "align".
+    };
+    voffset_t field;
+    voffset_t union_type_field;
+    uint8_t kind;
+    uint8_t align;
+    uoffset_t size;
+    uoffset_t target;
+  };
+
+  // The ops for a table are ops_[begin, end), in the order of its fields.
+  struct Plan {
+    uoffset_t begin;
+    uoffset_t end;
+    voffset_t numfields;
+  };
+
+  uoffset_t Copy(FlatBufferBuilder &fbb, uoffset_t plan, const Table &table);
+  uoffset_t CopyOffset(FlatBufferBuilder &fbb, const CopyOp &op,
+                       const Table &table, const uint8_t *ref);
+
+  std::unique_ptr<SchemaIndex> own_index_;  // If none was passed in.
+  const SchemaIndex *index_;
+  std::vector<Plan> plans_;  // Same order as the schema's objects.
+  std::vector<CopyOp> ops_;
+  // Offsets of copied subobjects, not yet stored in their table or vector.
+  std::vector<uoffset_t> offsets_;
+};
+
+// ------------------------- CONVERTING -------------------------
+
+// Converts FlatBuffers written with one version of a schema to another
+// version of it, without needing generated code for either.
+// Fields are matched by id, so may have been renamed. Matched fields must
+// have the same type, except that scalars (and vectors of them) may be
+// widened, e.g. from short to int or from int to double, and tables and
+// unions are converted recursively (with union types matched by name).
+// Fields that are no longer there (or deprecated) are dropped, and new fields
+// are left at their default. Values that relied on a default that has since
+// changed are written explicitly, so they read the same as before.
+// Buffers are assumed to be valid: verify them first if you don't trust them.
+class SchemaConverter {
+ public:
+  // Both schemas must outlive the converter.
+  SchemaConverter(const reflection::Schema &from,
+                  const reflection::Schema &to)
+    : from_(from), to_(to) {}
+
+  // Works out how to convert tables of type "from_root" to "to_root"
+  // (the root tables of the schemas by default), and everything they refer
+  // to. Returns false if the schemas are not compatible, with the reason in
+  // error().
+  bool Compile(const reflection::Object *from_root = nullptr,
+               const reflection::Object *to_root = nullptr);
+
+  const std::string &error() const { return error_; }
+
+  // Converts the buffer in "len" bytes at "buf", and finishes "fbb" with it
+  // (with a size prefix if "size_prefixed"), using the file identifier of
+  // the new schema, if any.
+  // Returns false if the buffer doesn't have the file identifier of the old
+  // schema, if any, or is too small.
+  // Can be used from many threads at once, with a builder for each.
+  // "offsets" is optional scratch space: pass the same one to each call
+  // (again, one per thread) to avoid allocating it for each buffer.
+  bool Convert(const uint8_t *buf, size_t len, FlatBufferBuilder *fbb,
+               bool size_prefixed = false,
+               std::vector<uoffset_t> *offsets = nullptr) const;
+
+  // Converts a root table (see Compile) into "fbb".
+  Offset<const Table *> ConvertTable(FlatBufferBuilder &fbb,
+                                     const Table &table,
+                                     std::vector<uoffset_t> *offsets = nullptr)
+                                     const {
+    std::vector<uoffset_t> local_offsets;
+    return ConvertTable(fbb, 0, table, offsets ? offsets : &local_offsets);
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  SchemaConverter(const SchemaConverter &);
+  SchemaConverter &operator=(const SchemaConverter &);
+
+  // How to convert a single field.
+  struct ConvertOp {
+    enum Kind {
+      kScalar,  // Converted from "from_type" to "to_type".
+      kStruct,  // Copied as "size" bytes.
+      // Everything from here on is stored as an offset, and created before
+      // the table itself.
+      kString,
+      kTable,            // "target" is the plan of the table.
+      kUnion,            // "target" is the first of "size" union_types_.
+      kVector,           // Scalars and structs copied as "size" bytes each,
+                         // aligned to "align".
+      kVectorOfScalars,  // Converted from "from_type" to "to_type".
+      kVectorOfStrings,
+      kVectorOfTables    // "target" is the plan of the tables.
+    };
+    uint8_t kind;
+    uint8_t from_type;  // reflection::BaseType of (elements of) scalars.
+    uint8_t to_type;
+    uint8_t align;
+    voffset_t from_field;
+    voffset_t to_field;
+    voffset_t from_type_field;  // Of unions.
+    voffset_t to_type_field;
+    uoffset_t size;
+    uoffset_t target;
+    // The old default (converted to a double if the new type is floating
+    // point), and the new one.
+    int64_t from_default_i;
+    double from_default_f;
+    int64_t to_default_i;
+    double to_default_f;
+  };
+
+  // The ops for a table are ops_[begin, end).
+  struct Plan {
+    uoffset_t begin;
+    uoffset_t end;
+    voffset_t numfields;
+  };
+
+  // What a union type converts to: a type in the new union, and its plan,
+  // or a type of 0 if the new union doesn't have it.
+  struct UnionType {
+    uint8_t to_type;
+    uoffset_t plan;
+  };
+
+  bool CompilePlan(const reflection::Object &from_obj,
+                   const reflection::Object &to_obj, uoffset_t *plan);
+  bool CompileField(const reflection::Object &from_obj,
+                    const reflection::Object &to_obj,
+                    const reflection::Field &from_field,
+                    const reflection::Field &to_field, ConvertOp *op);
+  bool Error(const std::string &msg);
+  uoffset_t ConvertTable(FlatBufferBuilder &fbb, uoffset_t plan,
+                         const Table &table,
+                         std::vector<uoffset_t> *offsets) const;
+  uoffset_t ConvertOffset(FlatBufferBuilder &fbb, const ConvertOp &op,
+                          const Table &table, const uint8_t *ref,
+                          std::vector<uoffset_t> *offsets) const;
+  void AddScalar(FlatBufferBuilder &fbb, const ConvertOp &op,
+                 const uint8_t *data) const;
+  uint8_t ConvertUnionType(const ConvertOp &op, const Table &table) const;
+
+  const reflection::Schema &from_;
+  const reflection::Schema &to_;
+  std::string error_;
+  std::vector<Plan> plans_;  // The root table's plan comes first.
+  std::vector<ConvertOp> ops_;
+  std::vector<UnionType> union_types_;
+  // Plans compiled so far, by the objects they convert between.
+  std::map<std::pair<const reflection::Object *, const reflection::Object *>,
+           uoffset_t> plan_indices_;
+};
 
 }  // namespace flatbuffers
 
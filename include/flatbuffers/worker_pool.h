@@ -0,0 +1,122 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_WORKER_POOL_H_
+#define FLATBUFFERS_WORKER_POOL_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A set of threads that is started once and then used for many batches of
+// work (see VerifyBuffers and ConvertFrames), rather than starting and
+// joining threads for each batch.
+
+namespace flatbuffers {
+
+class WorkerPool {
+ public:
+  // Starts "num_threads" - 1 threads (the number of cores if 0), since the
+  // thread calling Run() does its share of the work too.
+  explicit WorkerPool(size_t num_threads = 0)
+    : work_(nullptr), num_active_(0), num_busy_(0), generation_(0),
+      stop_(false) {
+    if (!num_threads) num_threads = std::thread::hardware_concurrency();
+    for (size_t i = 1; i < num_threads; i++)
+      threads_.push_back(std::thread([this, i]() { Loop(i); }));
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto it = threads_.begin(); it != threads_.end(); ++it) it->join();
+  }
+
+  // The number of threads work can run on, including the caller's.
+  size_t NumThreads() const { return threads_.size() + 1; }
+
+  // Call "work" on "num_threads" threads at once (or all of them if 0),
+  // the calling thread being one of them, and return once all calls have
+  // returned. "work" typically takes items from a shared atomic counter
+  // until there are none left.
+  // Only one thread may call Run() at a time.
+  void Run(const std::function<void()> &work, size_t num_threads = 0) {
+    if (!num_threads || num_threads > NumThreads()) num_threads = NumThreads();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      work_ = &work;
+      num_active_ = num_threads - 1;
+      num_busy_ = num_active_;
+      generation_++;
+    }
+    if (num_active_) start_.notify_all();
+    work();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return !num_busy_; });
+    work_ = nullptr;
+  }
+
+ private:
+  // You shouldn't really be copying instances of this class.
+  WorkerPool(const WorkerPool &);
+  WorkerPool &operator=(const WorkerPool &);
+
+  // What thread "index" (1 and up) runs: wait for a call to Run(), and take
+  // part in it unless it asked for fewer threads.
+  void Loop(size_t index) {
+    size_t generation = 0;
+    for (;;) {
+      const std::function<void()> *work;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [this, generation]() {
+          return stop_ || generation_ != generation;
+        });
+        if (stop_) return;
+        generation = generation_;
+        if (index > num_active_) continue;
+        work = work_;
+      }
+      (*work)();
+      bool last;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last = !--num_busy_;
+      }
+      if (last) done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;  // Signals a new Run(), or stop_.
+  std::condition_variable done_;   // Signals num_busy_ reaching 0.
+  const std::function<void()> *work_;
+  size_t num_active_;   // Worker threads taking part in the current Run().
+  size_t num_busy_;     // Of those, how many haven't finished yet.
+  size_t generation_;   // Incremented by every Run().
+  bool stop_;
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_WORKER_POOL_H_
@@ -16,6 +16,7 @@
 
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/idl.h"
+#include "flatbuffers/buffer_io.h"
 #include "flatbuffers/util.h"
 
 static void Error(const std::string &err, bool usage = false,
@@ -111,6 +112,9 @@ static void Error(const std::string &err, bool usage, bool show_exe_name) {
       "  --no-includes   Don\'t generate include statements for included\n"
       "                  schemas the generated file depends on (C++).\n"
       "  --gen-mutable   Generate accessors that can mutate buffers in-place.\n"
+      "  --gen-bounds-checked\n"
+      "                  Also generate accessors that check what they read lies\n"
+      "                  within the buffer, as an alternative to verifying it.\n"
       "  --gen-onefile   Generate single output file for C#\n"
       "  --raw-binary    Allow binaries without file_indentifier to be read.\n"
       "                  This may crash flatc given a mismatched schema.\n"
@@ -165,6 +169,8 @@ int main(int argc, const char *argv[]) {
         opts.scoped_enums = true;
       } else if(arg == "--gen-mutable") {
         opts.mutable_buffer = true;
+      } else if(arg == "--gen-bounds-checked") {
+        opts.bounds_checked = true;
       } else if(arg == "--gen-includes") {
         // Deprecated, remove this option some time in the future.
         printf("warning: --gen-includes is deprecated (it is now default)\n");
@@ -211,17 +217,18 @@ int main(int argc, const char *argv[]) {
   for (auto file_it = filenames.begin();
             file_it != filenames.end();
           ++file_it) {
-      std::string contents;
-      if (!flatbuffers::LoadFile(file_it->c_str(), true, &contents))
-        Error("unable to load file: " + *file_it);
-
       bool is_binary = static_cast<size_t>(file_it - filenames.begin()) >=
                        binary_files_from;
+      // Binaries are mapped rather than loaded, since they may be large, and
+      // the generators below read them straight from the mapping.
+      flatbuffers::MappedFile mapped;
       if (is_binary) {
+        if (!mapped.Open(file_it->c_str()))
+          Error("unable to load file: " + *file_it);
+        mapped.Advise(flatbuffers::MappedFile::kSequential);
+        // An empty file maps to nullptr, so clear builder_ for it instead.
         parser->builder_.Clear();
-        parser->builder_.PushFlatBuffer(
-          reinterpret_cast<const uint8_t *>(contents.c_str()),
-          contents.length());
+        parser->SetBinary(mapped.data(), mapped.size());
         if (!raw_binary) {
           // Generally reading binaries that do not correspond to the schema
           // will crash, and sadly there's no way around that when the binary
@@ -233,7 +240,9 @@ int main(int argc, const char *argv[]) {
                  *file_it +
                  "\" matches the schema, use --raw-binary to read this file"
                  " anyway.");
-          } else if (!flatbuffers::BufferHasIdentifier(contents.c_str(),
+          } else if (mapped.size() < sizeof(flatbuffers::uoffset_t) +
+                         flatbuffers::FlatBufferBuilder::kFileIdentifierLength ||
+                     !flatbuffers::BufferHasIdentifier(mapped.data(),
                                              parser->file_identifier_.c_str())) {
             Error("binary \"" +
                  *file_it +
@@ -243,6 +252,9 @@ int main(int argc, const char *argv[]) {
           }
         }
       } else {
+        std::string contents;
+        if (!flatbuffers::LoadFile(file_it->c_str(), true, &contents))
+          Error("unable to load file: " + *file_it);
         if (flatbuffers::GetExtension(*file_it) == "fbs") {
           // If we're processing multiple schemas, make sure to start each
           // one from scratch. If it depends on previous schemas it must do
@@ -289,6 +301,10 @@ int main(int argc, const char *argv[]) {
       }
 
       if (proto_mode) GenerateFBS(*parser, output_path, filebase, opts);
+
+      // The mapping is released at the end of this iteration, so make sure
+      // the parser doesn't hang on to it (later files output builder_).
+      if (is_binary) parser->SetBinary(nullptr, 0);
   }
 
   delete parser;
@@ -248,6 +248,18 @@ std::string GenFieldOffsetName(const FieldDef &field) {
   return "VT_" + uname;
 }
 
+// The type of the value that KeyCompareWithValue & KeyHashValue take, for
+// a key field.
+static std::string GenKeyType(const Parser &parser, const FieldDef &field,
+                              const GeneratorOptions &opts) {
+  if (field.value.type.base_type == BASE_TYPE_STRING) return "const char *";
+  if (opts.scoped_enums &&
+      field.value.type.enum_def &&
+      IsScalar(field.value.type.base_type))
+    return GenTypeGet(parser, field.value.type, " ", "const ", " *", true);
+  return GenTypeBasic(parser, field.value.type, false) + " ";
+}
+
 // Generate an accessor struct, builder structs & function for a table.
 static void GenTable(const Parser &parser, StructDef &struct_def,
                      const GeneratorOptions &opts, std::string *code_ptr) {
@@ -298,6 +310,22 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
       call += ")";
       code += GenUnderlyingCast(parser, field, true, call);
       code += "; }\n";
+      if (opts.bounds_checked) {
+        // Same, but checking the field (and what it points to) lies within
+        // the buffer, for reading buffers that haven't been verified.
+        code += "  " + GenTypeGet(parser, field.value.type, " ", "const ",
+                                  " *", true);
+        code += field.name + "(const flatbuffers::Verifier &verifier) const ";
+        code += "{ return ";
+        auto checked_call =
+            std::string(accessor, strlen(accessor) - 1) + "Checked<" +
+            GenTypeGet(parser, field.value.type, "", "const ", " *", false) +
+            ">(verifier, " + offsetstr;
+        if (is_scalar) checked_call += ", " + field.value.constant;
+        checked_call += ")";
+        code += GenUnderlyingCast(parser, field, true, checked_call);
+        code += "; }\n";
+      }
       if (opts.mutable_buffer) {
         if (is_scalar) {
           code += "  bool mutate_" + field.name + "(";
@@ -328,28 +356,55 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
       }
       // Generate a comparison function for this field if it is a key.
       if (field.key) {
+        auto is_string = field.value.type.base_type == BASE_TYPE_STRING;
         code += "  bool KeyCompareLessThan(const " + struct_def.name;
         code += " *o) const { return ";
-        if (field.value.type.base_type == BASE_TYPE_STRING) code += "*";
+        if (is_string) code += "*";
         code += field.name + "() < ";
-        if (field.value.type.base_type == BASE_TYPE_STRING) code += "*";
+        if (is_string) code += "*";
         code += "o->" + field.name + "(); }\n";
-        code += "  int KeyCompareWithValue(";
-        if (field.value.type.base_type == BASE_TYPE_STRING) {
-          code += "const char *val) const { return strcmp(" + field.name;
-          code += "()->c_str(), val); }\n";
+        auto key_type = GenKeyType(parser, field, opts);
+        code += "  int KeyCompareWithValue(" + key_type + "val) const { ";
+        if (is_string) {
+          code += "return strcmp(" + field.name + "()->c_str(), val); }\n";
         } else {
-          if (opts.scoped_enums &&
-            field.value.type.enum_def &&
-            IsScalar(field.value.type.base_type)) {
-            code += GenTypeGet(parser, field.value.type, " ", "const ", " *",
-                               true);
-          } else {
-            code += GenTypeBasic(parser, field.value.type, false);
-          }
-          code += " val) const { return " + field.name + "() < val ? -1 : ";
+          code += "return " + field.name + "() < val ? -1 : ";
           code += field.name + "() > val; }\n";
         }
+        // And the functions used by hash indices and key indices.
+        auto key = field.name + (is_string ? "()->c_str()" : "()");
+        auto underlying_val = GenUnderlyingCast(parser, field, false, "val");
+        code += "  uint32_t KeyHash() const { return KeyHashValue(";
+        code += key + "); }\n";
+        code += "  static uint32_t KeyHashValue(" + key_type + "val) { ";
+        code += "return flatbuffers::HashKey(" + underlying_val + "); }\n";
+        code += "  uint64_t KeyPrefix() const { return KeyPrefixValue(";
+        code += key + "); }\n";
+        code += "  static uint64_t KeyPrefixValue(" + key_type + "val) { ";
+        code += "return flatbuffers::KeyPrefix(" + underlying_val + "); }\n";
+      }
+      // Generate a lookup function using the index, if this is one.
+      auto index = field.attributes.Lookup("hash_index");
+      if (!index) index = field.attributes.Lookup("key_index");
+      if (index) {
+        auto &indexed = *struct_def.fields.Lookup(index->constant);
+        auto &element = *indexed.value.type.struct_def;
+        auto key_it = std::find_if(element.fields.vec.begin(),
+                                   element.fields.vec.end(),
+                                   [](const FieldDef *f) { return f->key; });
+        code += "  const " + WrapInNameSpace(parser, element) + " *";
+        code += indexed.name + "_by_key(";
+        code += GenKeyType(parser, **key_it, opts) + "val) const { ";
+        code += "auto vec = " + indexed.name + "(); return vec ? ";
+        code += "vec->LookupByKey(val, " + field.name + "()) : nullptr; }\n";
+        // Key indices keep the keys in order, so also support ranges.
+        if (field.attributes.Lookup("key_index")) {
+          code += "  flatbuffers::uoffset_t " + indexed.name;
+          code += "_lower_bound(" + GenKeyType(parser, **key_it, opts);
+          code += "val) const { auto vec = " + indexed.name + "(); ";
+          code += "return vec ? vec->LowerBoundByKey(val, " + field.name;
+          code += "()) : 0; }\n";
+        }
       }
     }
   }
@@ -772,6 +827,14 @@ std::string GenerateCPP(const Parser &parser,
         code += name + ">(buf); }\n\n";
       }
 
+      if (opts.bounds_checked) {
+        code += "inline const " + cpp_qualified_name + " *Get";
+        code += name;
+        code += "Checked(const flatbuffers::Verifier &verifier) { ";
+        code += "return verifier.GetRootChecked<";
+        code += cpp_qualified_name + ">(); }\n\n";
+      }
+
       // The root verifier:
       code += "inline bool Verify";
       code += name;
@@ -514,6 +514,22 @@ void Parser::ParseField(StructDef &struct_def) {
     // wasn't defined elsewhere.
     LookupCreateStruct(nested->constant);
   }
+  auto hash_index = field.attributes.Lookup("hash_index");
+  if (hash_index) {
+    if (hash_index->type.base_type != BASE_TYPE_STRING)
+      Error("hash_index attribute must be a string (the indexed field)");
+    if (field.value.type.base_type != BASE_TYPE_VECTOR ||
+        field.value.type.element != BASE_TYPE_UINT)
+      Error("hash_index attribute may only apply to a vector of uint");
+  }
+  auto key_index = field.attributes.Lookup("key_index");
+  if (key_index) {
+    if (key_index->type.base_type != BASE_TYPE_STRING)
+      Error("key_index attribute must be a string (the indexed field)");
+    if (field.value.type.base_type != BASE_TYPE_VECTOR ||
+        field.value.type.element != BASE_TYPE_ULONG)
+      Error("key_index attribute may only apply to a vector of ulong");
+  }
 
   if (typefield) {
     // If this field is a union, and it has a manually assigned id,
@@ -1351,6 +1367,7 @@ Type Parser::ParseTypeFromProtoType() {
 
 bool Parser::Parse(const char *source, const char **include_paths,
                    const char *source_filename) {
+  SetBinary(nullptr, 0);
   files_being_parsed_ = source_filename ? source_filename : "";
   if (source_filename &&
       included_files_.find(source_filename) == included_files_.end()) {
@@ -1477,6 +1494,27 @@ bool Parser::Parse(const char *source, const char **include_paths,
         Error("type referenced but not defined: " + (*it)->name);
       }
     }
+    for (auto it = structs_.vec.begin(); it != structs_.vec.end(); ++it) {
+      auto &fields = (*it)->fields.vec;
+      std::set<std::string> indexed_fields;
+      for (auto field_it = fields.begin(); field_it != fields.end();
+           ++field_it) {
+        auto index = (*field_it)->attributes.Lookup("hash_index");
+        if (!index) index = (*field_it)->attributes.Lookup("key_index");
+        if (!index) continue;
+        // Now that all tables are known, check what the index is for.
+        auto indexed = (*it)->fields.Lookup(index->constant);
+        if (!indexed ||
+            indexed->value.type.base_type != BASE_TYPE_VECTOR ||
+            indexed->value.type.element != BASE_TYPE_STRUCT ||
+            indexed->value.type.struct_def->fixed ||
+            !indexed->value.type.struct_def->has_key)
+          Error("index attribute must name a vector of tables with a key"
+                " in the same table: " + index->constant);
+        if (!indexed_fields.insert(index->constant).second)
+          Error("only one index per vector allowed: " + index->constant);
+      }
+    }
     for (auto it = enums_.vec.begin(); it != enums_.vec.end(); ++it) {
       auto &enum_def = **it;
       if (enum_def.is_union) {
@@ -1537,6 +1575,7 @@ template<typename T> void AssignIndices(const std::vector<T *> &defvec) {
 }
 
 void Parser::Serialize() {
+  SetBinary(nullptr, 0);
   builder_.Clear();
   AssignIndices(structs_.vec);
   AssignIndices(enums_.vec);
@@ -149,72 +149,228 @@ void SetAnyValueS(reflection::BaseType type, uint8_t *data, const char *val) {
   }
 }
 
-// Resize a FlatBuffer in-place by iterating through all offsets in the buffer
-// and adjusting them by "delta" if they straddle the start offset.
-// Once that is done, bytes can now be inserted/deleted safely.
-// "delta" may be negative (shrinking).
-// Unless "delta" is a multiple of the largest alignment, you'll create a small
-// amount of garbage space in the buffer (usually 0..7 bytes).
-// If your FlatBuffer's root table is not the schema's root table, you should
-// pass in your root_table type as well.
-class ResizeContext {
- public:
-  ResizeContext(const reflection::Schema &schema, uoffset_t start, int delta,
-                std::vector<uint8_t> *flatbuf,
-                const reflection::Object *root_table = nullptr)
-     : schema_(schema), startptr_(flatbuf->data() + start),
-       delta_(delta), buf_(*flatbuf),
-       dag_check_(flatbuf->size() / sizeof(uoffset_t), false) {
-    auto mask = static_cast<int>(sizeof(largest_scalar_t) - 1);
-    delta_ = (delta_ + mask) & ~mask;
-    if (!delta_) return;  // We can't shrink by less than largest_scalar_t.
-    // Now change all the offsets by delta_.
-    auto root = GetAnyRoot(buf_.data());
-    Straddle<uoffset_t, 1>(buf_.data(), root, buf_.data());
-    ResizeTable(root_table ? *root_table : *schema.root_table(), root);
-    // We can now add or remove bytes at start.
-    if (delta_ > 0) buf_.insert(buf_.begin() + start, delta_, 0);
-    else buf_.erase(buf_.begin() + start, buf_.begin() + start - delta_);
-  }
-
-  // Check if the range between first (lower address) and second straddles
-  // the insertion point. If it does, change the offset at offsetloc (of
-  // type T, with direction D).
-  template<typename T, int D> void Straddle(void *first, void *second,
-                                            void *offsetloc) {
-    if (first <= startptr_ && second >= startptr_) {
-      WriteScalar<T>(offsetloc, ReadScalar<T>(offsetloc) + delta_ * D);
-      DagCheck(offsetloc) = true;
+// Readers and writers for FieldHandle, doing the same as GetAnyValueI etc.
+// for a single type. "F" is the type values are converted to when set from
+// a double, and "S" the type they are converted to before printing or
+// reading as a double (so ulong values of 2^63 and up read as negative, as
+// with GetAnyValueF).
+template<typename T> static int64_t GetValueI(const uint8_t *data) {
+  return static_cast<int64_t>(ReadScalar<T>(data));
+}
+template<typename T, typename S> static double GetValueF(
+    const uint8_t *data) {
+  return static_cast<double>(static_cast<S>(ReadScalar<T>(data)));
+}
+template<typename T, typename S> static std::string GetValueS(
+    const uint8_t *data) {
+  return NumToString(static_cast<S>(ReadScalar<T>(data)));
+}
+template<typename T> static void SetValueI(uint8_t *data, int64_t val) {
+  WriteScalar(data, static_cast<T>(val));
+}
+template<typename T, typename F> static void SetValueF(uint8_t *data,
+                                                       double val) {
+  WriteScalar(data, static_cast<T>(static_cast<F>(val)));
+}
+static const String *GetValueString(const uint8_t *data) {
+  return reinterpret_cast<const String *>(data + ReadScalar<uoffset_t>(data));
+}
+static int64_t GetStringI(const uint8_t *data) {
+  return StringToInt(GetValueString(data)->c_str());
+}
+static double GetStringF(const uint8_t *data) {
+  return strtod(GetValueString(data)->c_str(), nullptr);
+}
+static std::string GetStringS(const uint8_t *data) {
+  return GetValueString(data)->c_str();
+}
+static int64_t GetNoneI(const uint8_t *) { return 0; }
+static double GetNoneF(const uint8_t *) { return 0.0; }
+static void SetNoneI(uint8_t *, int64_t) {}
+static void SetNoneF(uint8_t *, double) {}
+
+FieldHandle::FieldHandle(const reflection::Field &field,
+                         const reflection::Schema *schema) {
+  Init(field, schema);
+}
+
+FieldHandle::FieldHandle(const reflection::Field &field,
+                         const SchemaIndex &index) {
+  Init(field, &index.schema());
+}
+
+void FieldHandle::Init(const reflection::Field &field,
+                       const reflection::Schema *schema) {
+  offset_ = field.offset();
+  base_type_ = field.type()->base_type();
+  type_index_ = field.type()->index();
+  schema_ = schema;
+  default_i_ = field.default_integer();
+  default_f_ = field.default_real();
+  get_i_ = GetNoneI;
+  get_f_ = GetNoneF;
+  get_s_ = nullptr;
+  set_i_ = SetNoneI;
+  set_f_ = SetNoneF;
+# define FLATBUFFERS_HANDLE(T, F, S) \
+    get_i_ = GetValueI<T>; \
+    get_f_ = GetValueF<T, S>; \
+    get_s_ = GetValueS<T, S>; \
+    set_i_ = SetValueI<T>; \
+    set_f_ = SetValueF<T, F>
+  switch (base_type_) {
+    case reflection::UType:
+    case reflection::Bool:
+    case reflection::UByte:  FLATBUFFERS_HANDLE(uint8_t,  int64_t, int64_t);
+                             break;
+    case reflection::Byte:   FLATBUFFERS_HANDLE(int8_t,   int64_t, int64_t);
+                             break;
+    case reflection::Short:  FLATBUFFERS_HANDLE(int16_t,  int64_t, int64_t);
+                             break;
+    case reflection::UShort: FLATBUFFERS_HANDLE(uint16_t, int64_t, int64_t);
+                             break;
+    case reflection::Int:    FLATBUFFERS_HANDLE(int32_t,  int64_t, int64_t);
+                             break;
+    case reflection::UInt:   FLATBUFFERS_HANDLE(uint32_t, int64_t, int64_t);
+                             break;
+    case reflection::Long:   FLATBUFFERS_HANDLE(int64_t,  int64_t, int64_t);
+                             break;
+    case reflection::ULong:  FLATBUFFERS_HANDLE(uint64_t, int64_t, int64_t);
+                             break;
+    case reflection::Float:  FLATBUFFERS_HANDLE(float,    float,   double);
+                             break;
+    case reflection::Double: FLATBUFFERS_HANDLE(double,   double,  double);
+                             break;
+    case reflection::String:
+      get_i_ = GetStringI;
+      get_f_ = GetStringF;
+      get_s_ = GetStringS;
+      break;
+    default: break;  // Tables & vectors can only be read as strings.
+  }
+# undef FLATBUFFERS_HANDLE
+}
+
+void FieldHandle::SetS(uint8_t *data, const char *val) const {
+  if (base_type_ == reflection::Float || base_type_ == reflection::Double)
+    set_f_(data, strtod(val, nullptr));
+  else
+    set_i_(data, StringToInt(val));
+}
+
+SchemaIndex::SchemaIndex(const reflection::Schema &schema) : schema_(schema) {
+  auto objects = schema.objects();
+  size_t num_fields = 0;
+  for (auto it = objects->begin(); it != objects->end(); ++it)
+    num_fields += it->fields()->size();
+  // Keep the tables at most half full, so lookups rarely probe far.
+  size_t num_slots = 1;
+  while (num_slots < 2 * objects->size()) num_slots *= 2;
+  objects_.resize(num_slots, Slot<reflection::Object>());
+  num_slots = 1;
+  while (num_slots < 2 * num_fields) num_slots *= 2;
+  fields_.resize(num_slots, Slot<reflection::Field>());
+  for (uoffset_t i = 0; i < objects->size(); i++)
+    object_indices_[objects->Get(i)] = static_cast<int>(i);
+  for (auto it = objects->begin(); it != objects->end(); ++it) {
+    auto &objectdef = **it;
+    Insert(&objects_, nullptr, &objectdef);
+    inline_sizes_.push_back(objectdef.is_struct() ? objectdef.bytesize()
+                                                  : sizeof(uoffset_t));
+    auto fielddefs = objectdef.fields();
+    for (auto fit = fielddefs->begin(); fit != fielddefs->end(); ++fit) {
+      auto &fielddef = **fit;
+      Insert(&fields_, &objectdef, &fielddef);
+      if (fielddef.type()->base_type() != reflection::Union) continue;
+      UnionInfo info;
+      info.type_field = fielddefs->LookupByKey(
+        (fielddef.name()->str() + "_type").c_str());
+      assert(info.type_field);
+      info.first = union_types_.size();
+      auto enumvals = schema.enums()->Get(fielddef.type()->index())->values();
+      for (auto eit = enumvals->begin(); eit != enumvals->end(); ++eit) {
+        auto idx = info.first + static_cast<size_t>(eit->value());
+        if (union_types_.size() <= idx) union_types_.resize(idx + 1, -1);
+        if (eit->object()) union_types_[idx] = object_indices_[eit->object()];
+      }
+      info.num_types = union_types_.size() - info.first;
+      unions_[&fielddef] = info;
     }
   }
+}
+
+void MutationTransaction::AddEdit(const void *obj, uoffset_t old_bytes,
+                                  uoffset_t new_bytes, uoffset_t length,
+                                  uoffset_t keep, std::vector<uint8_t> *data) {
+  Edit edit;
+  edit.obj = static_cast<uoffset_t>(reinterpret_cast<const uint8_t *>(obj) -
+                                    buf_.data());
+  edit.end = edit.obj + static_cast<uoffset_t>(sizeof(uoffset_t)) + old_bytes;
+  // Unless the delta is a multiple of the largest alignment, the edit would
+  // misalign everything after it, so we leave a small amount of garbage space
+  // in the buffer instead (usually 0..7 bytes). This means we can't shrink
+  // by less than largest_scalar_t.
+  auto mask = static_cast<int>(sizeof(largest_scalar_t) - 1);
+  edit.delta = (static_cast<int>(new_bytes) - static_cast<int>(old_bytes) +
+                mask) & ~mask;
+  edit.length = length;
+  edit.keep = keep;
+  edit.data.swap(*data);
+  edits_.push_back(std::move(edit));
+}
+
+void MutationTransaction::SetString(const String *str,
+                                    const std::string &val) {
+  std::vector<uint8_t> data(val.begin(), val.end());
+  AddEdit(str, str->size(), static_cast<uoffset_t>(val.size()),
+          static_cast<uoffset_t>(val.size()), 0, &data);
+}
+
+void MutationTransaction::ResizeVector(const VectorOfAny *vec,
+                                       uoffset_t num_elems,
+                                       uoffset_t elem_size, uoffset_t newsize,
+                                       const uint8_t *newelems) {
+  std::vector<uint8_t> data;
+  if (newelems && newsize > num_elems)
+    data.assign(newelems, newelems + (newsize - num_elems) * elem_size);
+  AddEdit(vec, num_elems * elem_size, newsize * elem_size, newsize,
+          (std::min)(num_elems, newsize) * elem_size, &data);
+}
 
-  // This returns a boolean that records if the corresponding offset location
-  // has been modified already. If so, we can't even read the corresponding
-  // offset, since it is pointing to a location that is illegal until the
-  // resize actually happens.
-  // This must be checked for every offset, since we can't know which offsets
-  // will straddle and which won't.
-  uint8_t &DagCheck(void *offsetloc) {
-    auto dag_idx = reinterpret_cast<uoffset_t *>(offsetloc) -
-                   reinterpret_cast<uoffset_t *>(buf_.data());
-    return dag_check_[dag_idx];
-  }
-
-  void ResizeTable(const reflection::Object &objectdef, Table *table) {
-    if (DagCheck(table))
-      return;  // Table already visited.
-    auto vtable = table->GetVTable();
-    // Check if the vtable offset points beyond the insertion point.
-    Straddle<soffset_t, -1>(table, vtable, table);
-    // This direction shouldn't happen because vtables that sit before tables
-    // are always directly adjacent, but check just in case we ever change the
-    // way flatbuffers are built.
-    Straddle<soffset_t, -1>(vtable, table, table);
-    // Early out: since all fields inside the table must point forwards in
-    // memory, if the insertion point is before the table we can stop here.
-    auto tableloc = reinterpret_cast<uint8_t *>(table);
-    if (startptr_ <= tableloc) return;
-    // Check each field.
+// How far data at "pos" moves: the sum of the deltas of all edits that end
+// at or before it.
+int MutationTransaction::Shift(uoffset_t pos) const {
+  auto it = std::upper_bound(ends_.begin(), ends_.end(), pos);
+  return it == ends_.begin() ? 0 : shifts_[it - ends_.begin() - 1];
+}
+
+// Marks a table or vector as visited, returning false if it already was, so
+// that with DAGs we don't fix the same offsets twice.
+bool MutationTransaction::Visit(uoffset_t pos) {
+  auto idx = pos / sizeof(uoffset_t);
+  if (visited_[idx]) return false;
+  visited_[idx] = true;
+  return true;
+}
+
+// Fix the offset at "loc" for the commit, and return what it referred to.
+uoffset_t MutationTransaction::FixOffset(uoffset_t loc) {
+  auto offsetloc = buf_.data() + loc;
+  auto val = ReadScalar<uoffset_t>(offsetloc);
+  auto ref = loc + val;
+  auto shift = Shift(ref) - Shift(loc);
+  if (shift) WriteScalar(offsetloc, static_cast<uoffset_t>(val + shift));
+  return ref;
+}
+
+void MutationTransaction::FixTable(const reflection::Object &objectdef,
+                                   uoffset_t table) {
+  if (!Visit(table)) return;
+  auto tableptr = reinterpret_cast<Table *>(buf_.data() + table);
+  auto vtable_offset = ReadScalar<soffset_t>(tableptr);
+  // Since all fields inside the table must point forwards in memory, if the
+  // last edit is before the table we only need to fix its vtable offset.
+  if (table < ends_.back()) {
     auto fielddefs = objectdef.fields();
     for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
       auto &fielddef = **it;
@@ -222,49 +378,35 @@ class ResizeContext {
       // Ignore scalars.
       if (base_type <= reflection::Double) continue;
       // Ignore fields that are not stored.
-      auto offset = table->GetOptionalFieldOffset(fielddef.offset());
+      auto offset = tableptr->GetOptionalFieldOffset(fielddef.offset());
       if (!offset) continue;
       // Ignore structs.
       auto subobjectdef = base_type == reflection::Obj ?
         schema_.objects()->Get(fielddef.type()->index()) : nullptr;
       if (subobjectdef && subobjectdef->is_struct()) continue;
-      // Get this fields' offset, and read it if safe.
-      auto offsetloc = tableloc + offset;
-      if (DagCheck(offsetloc))
-        continue;  // This offset already visited.
-      auto ref = offsetloc + ReadScalar<uoffset_t>(offsetloc);
-      Straddle<uoffset_t, 1>(offsetloc, ref, offsetloc);
+      auto ref = FixOffset(table + offset);
       // Recurse.
       switch (base_type) {
-        case reflection::Obj: {
-          ResizeTable(*subobjectdef, reinterpret_cast<Table *>(ref));
+        case reflection::Obj:
+          FixTable(*subobjectdef, ref);
           break;
-        }
         case reflection::Vector: {
           auto elem_type = fielddef.type()->element();
-          if (elem_type != reflection::Obj && elem_type != reflection::String)
-            break;
-          auto vec = reinterpret_cast<Vector<uoffset_t> *>(ref);
-          auto elemobjectdef = elem_type == reflection::Obj
-            ? schema_.objects()->Get(fielddef.type()->index())
-            : nullptr;
-          if (elemobjectdef && elemobjectdef->is_struct()) break;
-          for (uoffset_t i = 0; i < vec->size(); i++) {
-            auto loc = vec->Data() + i * sizeof(uoffset_t);
-            if (DagCheck(loc))
-              continue;  // This offset already visited.
-            auto dest = loc + vec->Get(i);
-            Straddle<uoffset_t, 1>(loc, dest ,loc);
-            if (elemobjectdef)
-              ResizeTable(*elemobjectdef, reinterpret_cast<Table *>(dest));
+          if (elem_type == reflection::String) {
+            FixVector(nullptr, ref);
+          } else if (elem_type == reflection::Obj) {
+            auto elemobjectdef =
+              schema_.objects()->Get(fielddef.type()->index());
+            if (!elemobjectdef->is_struct()) FixVector(elemobjectdef, ref);
           }
           break;
         }
-        case reflection::Union: {
-          ResizeTable(GetUnionType(schema_, objectdef, fielddef, *table),
-                      reinterpret_cast<Table *>(ref));
+        case reflection::Union:
+          FixTable(index_ ? index_->GetUnionType(fielddef, *tableptr)
+                          : GetUnionType(schema_, objectdef, fielddef,
+                                         *tableptr),
+                   ref);
           break;
-        }
         case reflection::String:
           break;
         default:
@@ -272,58 +414,106 @@ class ResizeContext {
       }
     }
   }
+  // Do this last, since the above needs the vtable.
+  auto vtable = static_cast<uoffset_t>(table - vtable_offset);
+  auto shift = Shift(table) - Shift(vtable);
+  if (shift) WriteScalar(tableptr, vtable_offset + shift);
+}
 
-  void operator=(const ResizeContext &rc);
+// Fix a vector of strings (no "elemobjectdef") or tables.
+void MutationTransaction::FixVector(const reflection::Object *elemobjectdef,
+                                    uoffset_t vec) {
+  if (vec >= ends_.back() || !Visit(vec)) return;
+  auto size = ReadScalar<uoffset_t>(buf_.data() + vec);
+  for (uoffset_t i = 1; i <= size; i++) {
+    auto ref = FixOffset(vec + i * static_cast<uoffset_t>(sizeof(uoffset_t)));
+    if (elemobjectdef) FixTable(*elemobjectdef, ref);
+  }
+}
 
- private:
-  const reflection::Schema &schema_;
-  uint8_t *startptr_;
-  int delta_;
-  std::vector<uint8_t> &buf_;
-  std::vector<uint8_t> dag_check_;
-};
+void MutationTransaction::Commit() {
+  // Sort the edits by position, keeping only the last edit of each object.
+  std::stable_sort(edits_.begin(), edits_.end(),
+                   [](const Edit &a, const Edit &b) { return a.obj < b.obj; });
+  size_t num_edits = 0;
+  for (size_t i = 0; i < edits_.size(); i++) {
+    if (i + 1 < edits_.size() && edits_[i + 1].obj == edits_[i].obj) continue;
+    if (num_edits != i) edits_[num_edits] = std::move(edits_[i]);
+    num_edits++;
+  }
+  edits_.resize(num_edits);
+  ends_.clear();
+  shifts_.clear();
+  int shift = 0;
+  for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+    assert(it + 1 == edits_.end() || it->end <= (it + 1)->obj);
+    if (!it->delta) continue;
+    shift += it->delta;
+    ends_.push_back(it->end);
+    shifts_.push_back(shift);
+  }
+  if (!ends_.empty()) {
+    // Fix all offsets that straddle any of the edits, in one traversal.
+    visited_.assign(buf_.size() / sizeof(uoffset_t) + 1, false);
+    FixTable(root_table_, FixOffset(0));
+    visited_.clear();
+    // Now copy everything in between the edits to a new buffer.
+    std::vector<uint8_t> newbuf;
+    newbuf.reserve(buf_.size() + shift);
+    uoffset_t pos = 0;
+    for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+      if (!it->delta) continue;
+      if (it->delta > 0) {
+        newbuf.insert(newbuf.end(), buf_.begin() + pos,
+                      buf_.begin() + it->end);
+        newbuf.insert(newbuf.end(), it->delta, 0);
+      } else {
+        // This removes the last bytes of the old data.
+        newbuf.insert(newbuf.end(), buf_.begin() + pos,
+                      buf_.begin() + it->end + it->delta);
+      }
+      pos = it->end;
+    }
+    newbuf.insert(newbuf.end(), buf_.begin() + pos, buf_.end());
+    buf_.swap(newbuf);
+  }
+  // Finally, write the new lengths and data.
+  for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+    auto obj = buf_.data() + Remap(it->obj);
+    WriteScalar(obj, it->length);
+    auto data = obj + sizeof(uoffset_t);
+    auto size = it->end - it->obj - sizeof(uoffset_t) + it->delta;
+    // Clear what's left of the old data, since we don't want parts of it
+    // remaining.
+    memset(data + it->keep, 0, size - it->keep);
+    assert(it->keep + it->data.size() <= size);
+    if (!it->data.empty())
+      memcpy(data + it->keep, it->data.data(), it->data.size());
+  }
+  edits_.clear();
+}
 
 void SetString(const reflection::Schema &schema, const std::string &val,
-                      const String *str, std::vector<uint8_t> *flatbuf,
-                      const reflection::Object *root_table) {
-  auto delta = static_cast<int>(val.size()) - static_cast<int>(str->Length());
-  auto start = static_cast<uoffset_t>(reinterpret_cast<const uint8_t *>(str) -
-                                      flatbuf->data() +
-                                      sizeof(uoffset_t));
-  if (delta) {
-    // Clear the old string, since we don't want parts of it remaining.
-    memset(flatbuf->data() + start, 0, str->Length());
-    // Different size, we must expand (or contract).
-    ResizeContext(schema, start, delta, flatbuf, root_table);
-  }
-  // Copy new data. Safe because we created the right amount of space.
-  memcpy(flatbuf->data() + start, val.c_str(), val.size() + 1);
+               const String *str, std::vector<uint8_t> *flatbuf,
+               const reflection::Object *root_table,
+               const SchemaIndex *index) {
+  MutationTransaction transaction(schema, flatbuf, root_table, index);
+  transaction.SetString(str, val);
+  transaction.Commit();
 }
 
 uint8_t *ResizeAnyVector(const reflection::Schema &schema, uoffset_t newsize,
                          const VectorOfAny *vec, uoffset_t num_elems,
                          uoffset_t elem_size, std::vector<uint8_t> *flatbuf,
-                         const reflection::Object *root_table) {
-  auto delta_elem = static_cast<int>(newsize) - static_cast<int>(num_elems);
-  auto delta_bytes = delta_elem * static_cast<int>(elem_size);
-  auto vec_start = reinterpret_cast<const uint8_t *>(vec) - flatbuf->data();
-  auto start = static_cast<uoffset_t>(vec_start + sizeof(uoffset_t) +
-                                      elem_size * num_elems);
-  if (delta_bytes) {
-    if (delta_elem < 0) {
-      // Clear elements we're throwing away, since some might remain in the
-      // buffer.
-      auto size_clear = -delta_elem * elem_size;
-      memset(flatbuf->data() + start - size_clear, 0, size_clear);
-    }
-    ResizeContext(schema, start, delta_bytes, flatbuf, root_table);
-    WriteScalar(flatbuf->data() + vec_start, newsize);  // Length field.
-    // Set new elements to 0.. this can be overwritten by the caller.
-    if (delta_elem > 0) {
-      memset(flatbuf->data() + start, 0, delta_elem * elem_size);
-    }
-  }
-  return flatbuf->data() + start;
+                         const reflection::Object *root_table,
+                         const SchemaIndex *index) {
+  auto vec_start = static_cast<uoffset_t>(
+                     reinterpret_cast<const uint8_t *>(vec) - flatbuf->data());
+  MutationTransaction transaction(schema, flatbuf, root_table, index);
+  transaction.ResizeVector(vec, num_elems, elem_size, newsize);
+  transaction.Commit();
+  return flatbuf->data() + transaction.Remap(vec_start) + sizeof(uoffset_t) +
+         elem_size * num_elems;
 }
 
 const uint8_t *AddFlatBuffer(std::vector<uint8_t> &flatbuf,
@@ -351,7 +541,8 @@ void CopyInline(FlatBufferBuilder &fbb, const reflection::Field &fielddef,
 Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
                                 const reflection::Schema &schema,
                                 const reflection::Object &objectdef,
-                                const Table &table) {
+                                const Table &table,
+                                const SchemaIndex *index) {
   // Before we can construct the table, we have to first generate any
   // subobjects, and collect their offsets.
   std::vector<uoffset_t> offsets;
@@ -370,14 +561,16 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
         auto &subobjectdef = *schema.objects()->Get(fielddef.type()->index());
         if (!subobjectdef.is_struct()) {
           offset = CopyTable(fbb, schema, subobjectdef,
-                             *GetFieldT(table, fielddef)).o;
+                             *GetFieldT(table, fielddef), index).o;
         }
         break;
       }
       case reflection::Union: {
-        auto &subobjectdef = GetUnionType(schema, objectdef, fielddef, table);
+        auto &subobjectdef = index
+          ? index->GetUnionType(fielddef, table)
+          : GetUnionType(schema, objectdef, fielddef, table);
         offset = CopyTable(fbb, schema, subobjectdef,
-                           *GetFieldT(table, fielddef)).o;
+                           *GetFieldT(table, fielddef), index).o;
         break;
       }
       case reflection::Vector: {
@@ -402,7 +595,7 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
               std::vector<Offset<const Table *>> elements(vec->size());
               for (uoffset_t i = 0; i < vec->size(); i++) {
                 elements[i] =
-                  CopyTable(fbb, schema, *elemobjectdef, *vec->Get(i));
+                  CopyTable(fbb, schema, *elemobjectdef, *vec->Get(i), index);
               }
               offset = fbb.CreateVector(elements).o;
               break;
@@ -411,9 +604,14 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
           }
           default: {  // Scalars and structs.
             auto element_size = GetTypeSize(element_base_type);
-            if (elemobjectdef && elemobjectdef->is_struct())
+            auto element_align = element_size;
+            if (elemobjectdef && elemobjectdef->is_struct()) {
               element_size = elemobjectdef->bytesize();
-            fbb.StartVector(element_size, vec->size());
+              element_align = elemobjectdef->minalign();
+            }
+            // Struct sizes need not be a power of 2, so align by minalign.
+            fbb.StartVector(vec->size() * element_size / element_align,
+                            element_align);
             fbb.PushBytes(vec->Data(), element_size * vec->size());
             offset = fbb.EndVector(vec->size());
             break;
@@ -468,4 +666,611 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
   }
 }
 
+TableCopier::TableCopier(const reflection::Schema &schema,
+                         const SchemaIndex *index)
+    : own_index_(index ? nullptr : new SchemaIndex(schema)),
+      index_(index ? index : own_index_.get()) {
+  auto objects = schema.objects();
+  plans_.resize(objects->size());
+  for (uoffset_t i = 0; i < objects->size(); i++) {
+    auto &objectdef = *objects->Get(i);
+    auto &plan = plans_[i];
+    plan.begin = static_cast<uoffset_t>(ops_.size());
+    plan.numfields = static_cast<voffset_t>(objectdef.fields()->size());
+    // Structs are copied as a whole, so don't need a plan.
+    auto fielddefs = objectdef.is_struct() ? nullptr : objectdef.fields();
+    for (uoffset_t j = 0; fielddefs && j < fielddefs->size(); j++) {
+      auto &fielddef = *fielddefs->Get(j);
+      auto type = fielddef.type();
+      CopyOp op;
+      op.field = fielddef.offset();
+      op.union_type_field = 0;
+      op.align = 0;
+      op.size = 0;
+      op.target = 0;
+      switch (type->base_type()) {
+        case reflection::String:
+          op.kind = CopyOp::kString;
+          break;
+        case reflection::Obj: {
+          auto &subobjectdef = *objects->Get(type->index());
+          if (subobjectdef.is_struct()) {
+            op.kind = CopyOp::kInline;
+            op.align = static_cast<uint8_t>(subobjectdef.minalign());
+            op.size = subobjectdef.bytesize();
+          } else {
+            op.kind = CopyOp::kTable;
+            op.target = type->index();
+          }
+          break;
+        }
+        case reflection::Union: {
+          op.kind = CopyOp::kUnion;
+          // Plans are in the same order as objects, so the index's union
+          // types are the plans to use.
+          auto &info = index_->unions_.find(&fielddef)->second;
+          op.union_type_field = info.type_field->offset();
+          op.target = static_cast<uoffset_t>(info.first);
+          op.size = static_cast<uoffset_t>(info.num_types);
+          break;
+        }
+        case reflection::Vector: {
+          auto elem_type = type->element();
+          auto elemobjectdef = elem_type == reflection::Obj
+                               ? objects->Get(type->index())
+                               : nullptr;
+          if (elem_type == reflection::String) {
+            op.kind = CopyOp::kVectorOfStrings;
+          } else if (elemobjectdef && !elemobjectdef->is_struct()) {
+            op.kind = CopyOp::kVectorOfTables;
+            op.target = type->index();
+          } else {
+            op.kind = CopyOp::kVectorInline;
+            op.size = elemobjectdef
+                      ? elemobjectdef->bytesize()
+                      : static_cast<uoffset_t>(GetTypeSize(elem_type));
+            op.align = static_cast<uint8_t>(elemobjectdef
+                                            ? elemobjectdef->minalign()
+                                            : op.size);
+          }
+          break;
+        }
+        default:  // Scalars.
+          op.kind = CopyOp::kInline;
+          op.size = static_cast<uoffset_t>(GetTypeSize(type->base_type()));
+          op.align = static_cast<uint8_t>(op.size);
+          break;
+      }
+      ops_.push_back(op);
+    }
+    plan.end = static_cast<uoffset_t>(ops_.size());
+  }
+}
+
+uoffset_t TableCopier::Copy(FlatBufferBuilder &fbb, uoffset_t plan_idx,
+                            const Table &table) {
+  auto &plan = plans_[plan_idx];
+  auto tableloc = reinterpret_cast<const uint8_t *>(&table);
+  // Before we can construct the table, we have to first generate any
+  // subobjects, and collect their offsets.
+  auto first = offsets_.size();
+  for (auto i = plan.begin; i < plan.end; i++) {
+    auto &op = ops_[i];
+    if (op.kind == CopyOp::kInline) continue;
+    auto field_offset = table.GetOptionalFieldOffset(op.field);
+    if (!field_offset) continue;
+    auto offsetloc = tableloc + field_offset;
+    auto offset = CopyOffset(fbb, op, table,
+                             offsetloc + ReadScalar<uoffset_t>(offsetloc));
+    offsets_.push_back(offset);
+  }
+  // Now we can build the actual table from either offsets or scalar data.
+  auto start = fbb.StartTable();
+  auto next = first;
+  for (auto i = plan.begin; i < plan.end; i++) {
+    auto &op = ops_[i];
+    auto field_offset = table.GetOptionalFieldOffset(op.field);
+    if (!field_offset) continue;
+    if (op.kind == CopyOp::kInline) {
+      fbb.Align(op.align);
+      fbb.PushBytes(tableloc + field_offset, op.size);
+      fbb.TrackField(op.field, fbb.GetSize());
+    } else {
+      fbb.AddOffset(op.field, Offset<void>(offsets_[next++]));
+    }
+  }
+  offsets_.resize(first);
+  return fbb.EndTable(start, plan.numfields);
+}
+
+uoffset_t TableCopier::CopyOffset(FlatBufferBuilder &fbb, const CopyOp &op,
+                                  const Table &table, const uint8_t *ref) {
+  switch (op.kind) {
+    case CopyOp::kString:
+      return fbb.CreateString(reinterpret_cast<const String *>(ref)).o;
+    case CopyOp::kTable:
+      return Copy(fbb, op.target, *reinterpret_cast<const Table *>(ref));
+    case CopyOp::kUnion: {
+      auto union_type = table.GetField<uint8_t>(op.union_type_field, 0);
+      assert(union_type < op.size);
+      auto plan = index_->union_types_[op.target + union_type];
+      assert(plan >= 0);
+      return Copy(fbb, static_cast<uoffset_t>(plan),
+                  *reinterpret_cast<const Table *>(ref));
+    }
+    case CopyOp::kVectorOfStrings:
+    case CopyOp::kVectorOfTables: {
+      auto vec = reinterpret_cast<const Vector<uoffset_t> *>(ref);
+      auto size = vec->size();
+      auto first = offsets_.size();
+      for (uoffset_t i = 0; i < size; i++) {
+        auto elemloc = vec->Data() + i * sizeof(uoffset_t);
+        auto elem = elemloc + ReadScalar<uoffset_t>(elemloc);
+        auto offset = op.kind == CopyOp::kVectorOfStrings
+          ? fbb.CreateString(reinterpret_cast<const String *>(elem)).o
+          : Copy(fbb, op.target, *reinterpret_cast<const Table *>(elem));
+        offsets_.push_back(offset);
+      }
+      fbb.StartVector(size, sizeof(uoffset_t));
+      for (auto i = size; i > 0; ) {
+        fbb.PushElement(Offset<void>(offsets_[first + --i]));
+      }
+      offsets_.resize(first);
+      return fbb.EndVector(size);
+    }
+    case CopyOp::kVectorInline: {
+      auto vec = reinterpret_cast<const Vector<uint8_t> *>(ref);
+      auto size = vec->size();
+      fbb.StartVector(size * op.size / op.align, op.align);
+      fbb.PushBytes(vec->Data(), op.size * size);
+      return fbb.EndVector(size);
+    }
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
+static bool IsFloat(reflection::BaseType type) {
+  return type == reflection::Float || type == reflection::Double;
+}
+
+static bool IsSigned(reflection::BaseType type) {
+  return type == reflection::Byte || type == reflection::Short ||
+         type == reflection::Int || type == reflection::Long;
+}
+
+// Whether all values of scalar type "from" can be represented by "to".
+static bool IsWidening(reflection::BaseType from, reflection::BaseType to) {
+  if (from == to) return true;
+  if (to == reflection::Bool) return false;
+  auto from_size = GetTypeSize(from);
+  auto to_size = GetTypeSize(to);
+  if (IsFloat(from)) return to == reflection::Double;
+  // Integers fit exactly in a float or double of twice their size.
+  if (IsFloat(to)) return from_size * 2 <= to_size;
+  if (IsSigned(from) && !IsSigned(to)) return false;
+  return IsSigned(from) == IsSigned(to) ? from_size <= to_size
+                                        : from_size < to_size;
+}
+
+// Whether struct "from" (of schema "from_schema") has the same layout as "to":
+// the same size and alignment, and fields matched by id having the same
+// type and offset (so renaming fields is fine).
+static bool IsSameStruct(const reflection::Schema &from_schema,
+                         const reflection::Object &from,
+                         const reflection::Schema &to_schema,
+                         const reflection::Object &to) {
+  auto from_fields = from.fields();
+  auto to_fields = to.fields();
+  if (from.bytesize() != to.bytesize() || from.minalign() != to.minalign() ||
+      from_fields->size() != to_fields->size())
+    return false;
+  // Fields are sorted by name, so find them by id.
+  std::vector<const reflection::Field *> to_by_id(to_fields->size(), nullptr);
+  for (auto it = to_fields->begin(); it != to_fields->end(); ++it) {
+    if (it->id() >= to_by_id.size()) return false;
+    to_by_id[it->id()] = *it;
+  }
+  for (auto it = from_fields->begin(); it != from_fields->end(); ++it) {
+    auto &from_field = **it;
+    if (from_field.id() >= to_by_id.size() || !to_by_id[from_field.id()])
+      return false;
+    auto &to_field = *to_by_id[from_field.id()];
+    auto from_base = from_field.type()->base_type();
+    if (from_base != to_field.type()->base_type() ||
+        from_field.offset() != to_field.offset())
+      return false;
+    if (from_base == reflection::Obj &&
+        !IsSameStruct(from_schema,
+                      *from_schema.objects()->Get(from_field.type()->index()),
+                      to_schema,
+                      *to_schema.objects()->Get(to_field.type()->index())))
+      return false;
+  }
+  return true;
+}
+
+// Push a scalar of type "from_type" at "data" as "to_type".
+static void PushScalar(FlatBufferBuilder &fbb, reflection::BaseType from_type,
+                       reflection::BaseType to_type, const uint8_t *data) {
+  if (IsFloat(to_type)) {
+    auto val = GetAnyValueF(from_type, data);
+    if (to_type == reflection::Float) fbb.PushElement(static_cast<float>(val));
+    else fbb.PushElement(val);
+    return;
+  }
+  auto val = GetAnyValueI(from_type, data);
+# define FLATBUFFERS_PUSH(T) fbb.PushElement(static_cast<T>(val))
+  switch (to_type) {
+    case reflection::UType:
+    case reflection::Bool:
+    case reflection::UByte:  FLATBUFFERS_PUSH(uint8_t ); break;
+    case reflection::Byte:   FLATBUFFERS_PUSH(int8_t  ); break;
+    case reflection::Short:  FLATBUFFERS_PUSH(int16_t ); break;
+    case reflection::UShort: FLATBUFFERS_PUSH(uint16_t); break;
+    case reflection::Int:    FLATBUFFERS_PUSH(int32_t ); break;
+    case reflection::UInt:   FLATBUFFERS_PUSH(uint32_t); break;
+    case reflection::Long:   FLATBUFFERS_PUSH(int64_t ); break;
+    case reflection::ULong:  FLATBUFFERS_PUSH(uint64_t); break;
+    default: assert(false);
+  }
+# undef FLATBUFFERS_PUSH
+}
+
+bool SchemaConverter::Error(const std::string &msg) {
+  error_ = msg;
+  return false;
+}
+
+bool SchemaConverter::Compile(const reflection::Object *from_root,
+                              const reflection::Object *to_root) {
+  plans_.clear();
+  ops_.clear();
+  union_types_.clear();
+  plan_indices_.clear();
+  error_.clear();
+  if (!from_root) from_root = from_.root_table();
+  if (!to_root) to_root = to_.root_table();
+  if (!from_root || !to_root) return Error("no root table");
+  uoffset_t plan;
+  return CompilePlan(*from_root, *to_root, &plan);
+}
+
+bool SchemaConverter::CompilePlan(const reflection::Object &from_obj,
+                                  const reflection::Object &to_obj,
+                                  uoffset_t *plan) {
+  auto key = std::make_pair(&from_obj, &to_obj);
+  auto it = plan_indices_.find(key);
+  if (it != plan_indices_.end()) {
+    *plan = it->second;
+    return true;
+  }
+  // Register the plan before compiling its fields, since tables may
+  // (indirectly) refer to themselves.
+  *plan = static_cast<uoffset_t>(plans_.size());
+  plan_indices_[key] = *plan;
+  plans_.push_back(Plan());
+  // Old fields by id.
+  std::vector<const reflection::Field *> from_fields;
+  auto from_fielddefs = from_obj.fields();
+  for (auto fit = from_fielddefs->begin(); fit != from_fielddefs->end();
+       ++fit) {
+    if (fit->deprecated()) continue;
+    if (from_fields.size() <= fit->id()) from_fields.resize(fit->id() + 1);
+    from_fields[fit->id()] = *fit;
+  }
+  std::vector<ConvertOp> ops;
+  voffset_t numfields = 0;
+  auto to_fielddefs = to_obj.fields();
+  for (auto fit = to_fielddefs->begin(); fit != to_fielddefs->end(); ++fit) {
+    auto &to_field = **fit;
+    numfields = (std::max)(numfields,
+                           static_cast<voffset_t>(to_field.id() + 1));
+    if (to_field.deprecated()) continue;
+    // Union types are written along with their union.
+    if (to_field.type()->base_type() == reflection::UType) continue;
+    auto from_field = to_field.id() < from_fields.size()
+                      ? from_fields[to_field.id()]
+                      : nullptr;
+    if (!from_field) {
+      if (to_field.required())
+        return Error("new field is required: " + to_obj.name()->str() + "." +
+                     to_field.name()->str());
+      continue;  // New field, which will be its default.
+    }
+    ConvertOp op;
+    if (!CompileField(from_obj, to_obj, *from_field, to_field, &op))
+      return false;
+    ops.push_back(op);
+  }
+  // The above may have added other plans, so add ours after theirs.
+  auto &compiled = plans_[*plan];
+  compiled.begin = static_cast<uoffset_t>(ops_.size());
+  ops_.insert(ops_.end(), ops.begin(), ops.end());
+  compiled.end = static_cast<uoffset_t>(ops_.size());
+  compiled.numfields = numfields;
+  return true;
+}
+
+bool SchemaConverter::CompileField(const reflection::Object &from_obj,
+                                   const reflection::Object &to_obj,
+                                   const reflection::Field &from_field,
+                                   const reflection::Field &to_field,
+                                   ConvertOp *op) {
+  auto from_type = from_field.type();
+  auto to_type = to_field.type();
+  memset(op, 0, sizeof(ConvertOp));
+  op->from_field = from_field.offset();
+  op->to_field = to_field.offset();
+  op->from_default_i = from_field.default_integer();
+  op->from_default_f = IsFloat(from_type->base_type())
+    ? from_field.default_real()
+    : static_cast<double>(from_field.default_integer());
+  op->to_default_i = to_field.default_integer();
+  op->to_default_f = to_field.default_real();
+  auto from_base = from_type->base_type();
+  auto to_base = to_type->base_type();
+  auto incompatible = [&]() {
+    return Error("can't convert " + from_obj.name()->str() + "." +
+                 from_field.name()->str() + " (" +
+                 EnumNameBaseType(from_base) + ") to " +
+                 to_obj.name()->str() + "." + to_field.name()->str() + " (" +
+                 EnumNameBaseType(to_base) + ")");
+  };
+  if (from_base == reflection::Union || to_base == reflection::Union) {
+    if (from_base != to_base) return incompatible();
+    op->kind = ConvertOp::kUnion;
+    auto from_type_field = from_obj.fields()->LookupByKey(
+      (from_field.name()->str() + "_type").c_str());
+    auto to_type_field = to_obj.fields()->LookupByKey(
+      (to_field.name()->str() + "_type").c_str());
+    if (!from_type_field || !to_type_field) return incompatible();
+    op->from_type_field = from_type_field->offset();
+    op->to_type_field = to_type_field->offset();
+    auto from_vals = from_.enums()->Get(from_type->index())->values();
+    auto to_vals = to_.enums()->Get(to_type->index())->values();
+    op->target = static_cast<uoffset_t>(union_types_.size());
+    for (auto it = from_vals->begin(); it != from_vals->end(); ++it) {
+      op->size = (std::max)(op->size, static_cast<uoffset_t>(it->value() + 1));
+    }
+    UnionType none = { 0, 0 };
+    union_types_.resize(op->target + op->size, none);
+    // Match types by name.
+    for (auto it = from_vals->begin(); it != from_vals->end(); ++it) {
+      if (!it->object()) continue;
+      auto name = it->name();
+      for (auto tit = to_vals->begin(); tit != to_vals->end(); ++tit) {
+        if (!tit->object() || tit->name()->size() != name->size() ||
+            memcmp(tit->name()->Data(), name->Data(), name->size()))
+          continue;
+        uoffset_t plan;
+        if (!CompilePlan(*it->object(), *tit->object(), &plan)) return false;
+        UnionType union_type = { static_cast<uint8_t>(tit->value()), plan };
+        union_types_[op->target + it->value()] = union_type;
+      }
+    }
+    return true;
+  }
+  auto is_vector = from_base == reflection::Vector;
+  if (is_vector != (to_base == reflection::Vector)) return incompatible();
+  if (is_vector) {
+    from_base = from_type->element();
+    to_base = to_type->element();
+  }
+  if (from_base <= reflection::Double && to_base <= reflection::Double) {
+    if (!IsWidening(from_base, to_base)) return incompatible();
+    op->from_type = static_cast<uint8_t>(from_base);
+    op->to_type = static_cast<uint8_t>(to_base);
+    op->size = static_cast<uoffset_t>(GetTypeSize(to_base));
+    op->align = static_cast<uint8_t>(op->size);
+    op->kind = !is_vector ? ConvertOp::kScalar
+               : from_base == to_base ? ConvertOp::kVector
+               : ConvertOp::kVectorOfScalars;
+  } else if (from_base == reflection::String && to_base == reflection::String) {
+    op->kind = is_vector ? ConvertOp::kVectorOfStrings : ConvertOp::kString;
+  } else if (from_base == reflection::Obj && to_base == reflection::Obj) {
+    auto &from_sub = *from_.objects()->Get(from_type->index());
+    auto &to_sub = *to_.objects()->Get(to_type->index());
+    if (from_sub.is_struct() != to_sub.is_struct()) return incompatible();
+    if (from_sub.is_struct()) {
+      // Structs can't change, so are copied as is.
+      if (!IsSameStruct(from_, from_sub, to_, to_sub)) return incompatible();
+      op->kind = is_vector ? ConvertOp::kVector : ConvertOp::kStruct;
+      op->size = from_sub.bytesize();
+      op->align = static_cast<uint8_t>(from_sub.minalign());
+    } else {
+      op->kind = is_vector ? ConvertOp::kVectorOfTables : ConvertOp::kTable;
+      if (!CompilePlan(from_sub, to_sub, &op->target)) return false;
+    }
+  } else {
+    return incompatible();
+  }
+  return true;
+}
+
+bool SchemaConverter::Convert(const uint8_t *buf, size_t len,
+                              FlatBufferBuilder *fbb,
+                              bool size_prefixed,
+                              std::vector<uoffset_t> *offsets) const {
+  assert(!plans_.empty());  // Call Compile() first.
+  if (len < sizeof(uoffset_t) || ReadScalar<uoffset_t>(buf) >= len)
+    return false;
+  auto from_ident = from_.file_ident();
+  if (from_ident && from_ident->size() &&
+      (len < sizeof(uoffset_t) + FlatBufferBuilder::kFileIdentifierLength ||
+       !BufferHasIdentifier(buf, from_ident->c_str())))
+    return false;
+  auto root = ConvertTable(*fbb, *GetAnyRoot(buf), offsets);
+  auto to_ident = to_.file_ident();
+  auto file_identifier = to_ident && to_ident->size() ? to_ident->c_str()
+                                                      : nullptr;
+  if (size_prefixed) fbb->FinishSizePrefixed(root, file_identifier);
+  else fbb->Finish(root, file_identifier);
+  return true;
+}
+
+uoffset_t SchemaConverter::ConvertTable(FlatBufferBuilder &fbb,
+                                        uoffset_t plan_idx,
+                                        const Table &table,
+                                        std::vector<uoffset_t> *offsets)
+                                        const {
+  auto &plan = plans_[plan_idx];
+  auto tableloc = reinterpret_cast<const uint8_t *>(&table);
+  // Before we can construct the table, we have to first generate any
+  // subobjects, and collect their offsets.
+  auto first = offsets->size();
+  for (auto i = plan.begin; i < plan.end; i++) {
+    auto &op = ops_[i];
+    if (op.kind < ConvertOp::kString) continue;
+    auto field_offset = table.GetOptionalFieldOffset(op.from_field);
+    if (!field_offset) continue;
+    auto offsetloc = tableloc + field_offset;
+    auto offset = ConvertOffset(fbb, op, table,
+                                offsetloc + ReadScalar<uoffset_t>(offsetloc),
+                                offsets);
+    offsets->push_back(offset);
+  }
+  // Now we can build the actual table from either offsets or scalar data.
+  auto start = fbb.StartTable();
+  auto next = first;
+  for (auto i = plan.begin; i < plan.end; i++) {
+    auto &op = ops_[i];
+    auto field_offset = table.GetOptionalFieldOffset(op.from_field);
+    auto data = field_offset ? tableloc + field_offset : nullptr;
+    switch (op.kind) {
+      case ConvertOp::kScalar:
+        AddScalar(fbb, op, data);
+        break;
+      case ConvertOp::kStruct:
+        if (!data) break;
+        fbb.Align(op.align);
+        fbb.PushBytes(data, op.size);
+        fbb.TrackField(op.to_field, fbb.GetSize());
+        break;
+      default: {
+        if (!data) break;
+        auto offset = (*offsets)[next++];
+        if (!offset) break;  // A union type the new schema doesn't have.
+        if (op.kind == ConvertOp::kUnion) {
+          fbb.AddElement<uint8_t>(op.to_type_field,
+                                  ConvertUnionType(op, table), 0);
+        }
+        fbb.AddOffset(op.to_field, Offset<void>(offset));
+        break;
+      }
+    }
+  }
+  offsets->resize(first);
+  return fbb.EndTable(start, plan.numfields);
+}
+
+// Add a scalar field, reading it from "data" if present, or using the old
+// default otherwise. As usual, it is only stored if not the (new) default.
+void SchemaConverter::AddScalar(FlatBufferBuilder &fbb, const ConvertOp &op,
+                                const uint8_t *data) const {
+  auto from_type = static_cast<reflection::BaseType>(op.from_type);
+  auto to_type = static_cast<reflection::BaseType>(op.to_type);
+  if (IsFloat(to_type)) {
+    auto val = data ? GetAnyValueF(from_type, data) : op.from_default_f;
+    if (to_type == reflection::Float) {
+      fbb.AddElement(op.to_field, static_cast<float>(val),
+                     static_cast<float>(op.to_default_f));
+    } else {
+      fbb.AddElement(op.to_field, val, op.to_default_f);
+    }
+    return;
+  }
+  auto val = data ? GetAnyValueI(from_type, data) : op.from_default_i;
+# define FLATBUFFERS_ADD(T) \
+    fbb.AddElement(op.to_field, static_cast<T>(val), \
+                   static_cast<T>(op.to_default_i))
+  switch (to_type) {
+    case reflection::UType:
+    case reflection::Bool:
+    case reflection::UByte:  FLATBUFFERS_ADD(uint8_t ); break;
+    case reflection::Byte:   FLATBUFFERS_ADD(int8_t  ); break;
+    case reflection::Short:  FLATBUFFERS_ADD(int16_t ); break;
+    case reflection::UShort: FLATBUFFERS_ADD(uint16_t); break;
+    case reflection::Int:    FLATBUFFERS_ADD(int32_t ); break;
+    case reflection::UInt:   FLATBUFFERS_ADD(uint32_t); break;
+    case reflection::Long:   FLATBUFFERS_ADD(int64_t ); break;
+    case reflection::ULong:  FLATBUFFERS_ADD(uint64_t); break;
+    default: assert(false);
+  }
+# undef FLATBUFFERS_ADD
+}
+
+uint8_t SchemaConverter::ConvertUnionType(const ConvertOp &op,
+                                          const Table &table) const {
+  auto from_type = table.GetField<uint8_t>(op.from_type_field, 0);
+  return from_type < op.size ? union_types_[op.target + from_type].to_type : 0;
+}
+
+uoffset_t SchemaConverter::ConvertOffset(FlatBufferBuilder &fbb,
+                                         const ConvertOp &op,
+                                         const Table &table,
+                                         const uint8_t *ref,
+                                         std::vector<uoffset_t> *offsets)
+                                         const {
+  switch (op.kind) {
+    case ConvertOp::kString:
+      return fbb.CreateString(reinterpret_cast<const String *>(ref)).o;
+    case ConvertOp::kTable:
+      return ConvertTable(fbb, op.target, *reinterpret_cast<const Table *>(ref),
+                          offsets);
+    case ConvertOp::kUnion: {
+      if (!ConvertUnionType(op, table)) return 0;
+      auto from_type = table.GetField<uint8_t>(op.from_type_field, 0);
+      return ConvertTable(fbb, union_types_[op.target + from_type].plan,
+                          *reinterpret_cast<const Table *>(ref), offsets);
+    }
+    case ConvertOp::kVector: {
+      auto vec = reinterpret_cast<const Vector<uint8_t> *>(ref);
+      auto size = vec->size();
+      fbb.StartVector(size * op.size / op.align, op.align);
+      fbb.PushBytes(vec->Data(), op.size * size);
+      return fbb.EndVector(size);
+    }
+    case ConvertOp::kVectorOfScalars: {
+      auto vec = reinterpret_cast<const Vector<uint8_t> *>(ref);
+      auto size = vec->size();
+      auto from_type = static_cast<reflection::BaseType>(op.from_type);
+      auto from_size = GetTypeSize(from_type);
+      fbb.StartVector(size * op.size / op.align, op.align);
+      for (auto i = size; i > 0; ) {
+        --i;
+        PushScalar(fbb, from_type,
+                   static_cast<reflection::BaseType>(op.to_type),
+                   vec->Data() + i * from_size);
+      }
+      return fbb.EndVector(size);
+    }
+    case ConvertOp::kVectorOfStrings:
+    case ConvertOp::kVectorOfTables: {
+      auto vec = reinterpret_cast<const Vector<uoffset_t> *>(ref);
+      auto size = vec->size();
+      auto first = offsets->size();
+      for (uoffset_t i = 0; i < size; i++) {
+        auto elemloc = vec->Data() + i * sizeof(uoffset_t);
+        auto elem = elemloc + ReadScalar<uoffset_t>(elemloc);
+        auto offset = op.kind == ConvertOp::kVectorOfStrings
+          ? fbb.CreateString(reinterpret_cast<const String *>(elem)).o
+          : ConvertTable(fbb, op.target, *reinterpret_cast<const Table *>(elem),
+                         offsets);
+        offsets->push_back(offset);
+      }
+      fbb.StartVector(size, sizeof(uoffset_t));
+      for (auto i = size; i > 0; ) {
+        fbb.PushElement(Offset<void>((*offsets)[first + --i]));
+      }
+      offsets->resize(first);
+      return fbb.EndVector(size);
+    }
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
 }  // namespace flatbuffers
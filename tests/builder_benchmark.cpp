@@ -0,0 +1,245 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Timings of the FlatBufferBuilder paths that were made faster: vtable
+// deduplication, bulk vectors, segmented buffers, builder pools and arenas,
+// shared strings and keyed lookups. Not a test: it checks nothing, and is
+// only built with FLATBUFFERS_BUILD_BENCHMARKS.
+// Run it on an optimized build; the numbers only mean anything relative to
+// each other, or to a run of an older version on the same machine.
+
+#include <chrono>
+#include <stdio.h>
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/arena.h"
+#include "flatbuffers/builder_pool.h"
+#include "flatbuffers/util.h"
+
+#include "key_test_generated.h"
+
+// Results are added up here, so the compiler can't drop the work.
+size_t sink = 0;
+
+// Runs "f", which does "n" operations, "repeat" times, and prints the
+// fastest time per operation.
+template<typename F> void Time(const char *name, size_t n, F f,
+                               int repeat = 3) {
+  double best = 0;
+  for (int i = 0; i < repeat; i++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                     std::chrono::steady_clock::now() - start).count();
+    if (!i || elapsed < best) best = elapsed;
+  }
+  printf("%-44s %10.1f ns/op\n", name, best / n);
+}
+
+// Encode time per table, for the same number of tables spread over more and
+// more distinct vtables: with a vtable index this should stay flat, rather
+// than grow with the number of shapes.
+void VTableDedupBenchmark() {
+  const size_t kNumTables = 100000;
+  const flatbuffers::voffset_t kNumFields = 17;  // Enough for 2^17 shapes.
+  flatbuffers::FlatBufferBuilder fbb;
+  for (size_t shapes = 10; shapes <= 100000; shapes *= 10) {
+    char name[64];
+    snprintf(name, sizeof(name), "EndTable, %d shapes",
+             static_cast<int>(shapes));
+    Time(name, kNumTables, [&]() {
+      fbb.Clear();
+      for (size_t i = 0; i < kNumTables; i++) {
+        // The fields present are the bits of the shape number.
+        auto shape = i % shapes + 1;
+        auto start = fbb.StartTable();
+        for (flatbuffers::voffset_t f = 0; f < kNumFields; f++) {
+          if (shape & (1 << f))
+            fbb.AddElement<uint8_t>(flatbuffers::FieldIndexToOffset(f), 1, 0);
+        }
+        fbb.EndTable(start, kNumFields);
+      }
+      sink += fbb.GetSize();
+    });
+  }
+}
+
+void VectorBenchmark() {
+  const size_t kLen = 1000000;
+  std::vector<uint32_t> ints(kLen);
+  for (size_t i = 0; i < kLen; i++) ints[i] = static_cast<uint32_t>(i);
+  std::vector<double> doubles(ints.begin(), ints.end());
+  flatbuffers::FlatBufferBuilder fbb;
+  Time("CreateVector, uint32 element", kLen, [&]() {
+    fbb.Clear();
+    sink += fbb.CreateVector(ints).o;
+  });
+  Time("CreateVector, double element", kLen, [&]() {
+    fbb.Clear();
+    sink += fbb.CreateVector(doubles).o;
+  });
+  Time("PushElement loop, uint32 element", kLen, [&]() {
+    fbb.Clear();
+    fbb.StartVector(kLen, sizeof(uint32_t));
+    for (size_t i = kLen; i > 0; ) fbb.PushElement(ints[--i]);
+    sink += fbb.EndVector(kLen);
+  });
+}
+
+// A large buffer built from many small vectors: growing a contiguous buffer
+// copies it each time, a segmented one never does.
+void SegmentedBenchmark() {
+  const size_t kNumVectors = 4096;
+  std::vector<uint8_t> bytes(4096, 1);
+  for (int segmented = 0; segmented < 2; segmented++) {
+    Time(segmented ? "16MB buffer, segmented" : "16MB buffer, contiguous",
+         kNumVectors, [&]() {
+      flatbuffers::FlatBufferBuilder fbb;
+      fbb.SetSegmented(segmented != 0);
+      for (size_t i = 0; i < kNumVectors; i++)
+        sink += fbb.CreateVector(bytes).o;
+    });
+  }
+}
+
+// A small message, as a server might build per request.
+flatbuffers::uoffset_t BuildMessage(flatbuffers::FlatBufferBuilder &fbb) {
+  std::vector<flatbuffers::Offset<KeyTest::Reading>> readings;
+  for (int i = 0; i < 8; i++)
+    readings.push_back(KeyTest::CreateReading(fbb, i));
+  // The index follows the order of the sorted vector, so is created after it.
+  auto vec = fbb.CreateVectorOfSortedTables(&readings);
+  fbb.Finish(KeyTest::CreateReadings(fbb, vec, fbb.CreateHashIndex(readings)));
+  return fbb.GetSize();
+}
+
+void PoolBenchmark() {
+  const size_t kNumMessages = 100000;
+  Time("message, new builder each", kNumMessages, [&]() {
+    for (size_t i = 0; i < kNumMessages; i++) {
+      flatbuffers::FlatBufferBuilder fbb;
+      sink += BuildMessage(fbb);
+    }
+  });
+  flatbuffers::BuilderPool pool;
+  Time("message, BuilderPool", kNumMessages, [&]() {
+    for (size_t i = 0; i < kNumMessages; i++) {
+      flatbuffers::BuilderPool::Lease fbb(pool);
+      sink += BuildMessage(*fbb);
+    }
+  });
+  flatbuffers::arena_allocator arena;
+  Time("message, arena_allocator", kNumMessages, [&]() {
+    for (size_t i = 0; i < kNumMessages; i++) {
+      {
+        flatbuffers::FlatBufferBuilder fbb(1024, &arena);
+        sink += BuildMessage(fbb);
+      }
+      if (i % 1000 == 999) arena.reset();
+    }
+    arena.reset();
+  });
+}
+
+void SharedStringBenchmark() {
+  const size_t kNumStrings = 100000;
+  std::vector<std::string> names;
+  for (int i = 0; i < 100; i++)
+    names.push_back("name" + flatbuffers::NumToString(i));
+  flatbuffers::FlatBufferBuilder fbb;
+  Time("CreateString, 100 distinct", kNumStrings, [&]() {
+    fbb.Clear();
+    for (size_t i = 0; i < kNumStrings; i++)
+      sink += fbb.CreateString(names[i % names.size()]).o;
+  });
+  Time("CreateSharedString, 100 distinct", kNumStrings, [&]() {
+    fbb.Clear();
+    for (size_t i = 0; i < kNumStrings; i++)
+      sink += fbb.CreateSharedString(names[i % names.size()]).o;
+  });
+}
+
+void LookupBenchmark() {
+  const int kNumKeys = 50000;
+  // String keys: binary search vs. hash index.
+  flatbuffers::FlatBufferBuilder entries_fbb;
+  std::vector<flatbuffers::Offset<KeyTest::Entry>> entries;
+  std::vector<std::string> names;
+  for (int i = 0; i < kNumKeys; i++) {
+    names.push_back("entry" + flatbuffers::NumToString(i));
+    entries.push_back(KeyTest::CreateEntry(entries_fbb,
+                        entries_fbb.CreateString(names.back())));
+  }
+  auto entries_vec = entries_fbb.CreateVectorOfSortedTables(&entries);
+  auto hash_index = entries_fbb.CreateHashIndex(entries);
+  entries_fbb.Finish(KeyTest::CreateEntries(entries_fbb, entries_vec,
+                                            hash_index));
+  Time("Build 50k entries with hash index", kNumKeys, [&]() {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<KeyTest::Entry>> v;
+    for (int i = 0; i < kNumKeys; i++)
+      v.push_back(KeyTest::CreateEntry(fbb, fbb.CreateString(names[i])));
+    auto vec = fbb.CreateVectorOfSortedTables(&v);
+    fbb.Finish(KeyTest::CreateEntries(fbb, vec, fbb.CreateHashIndex(v)));
+    sink += fbb.GetSize();
+  });
+  auto root = flatbuffers::GetRoot<KeyTest::Entries>(
+                entries_fbb.GetBufferPointer());
+  Time("LookupByKey, string, binary search", kNumKeys, [&]() {
+    for (int i = 0; i < kNumKeys; i++)
+      sink += root->entries()->LookupByKey(names[i].c_str()) != nullptr;
+  });
+  Time("LookupByKey, string, hash index", kNumKeys, [&]() {
+    for (int i = 0; i < kNumKeys; i++)
+      sink += root->entries_by_key(names[i].c_str()) != nullptr;
+  });
+
+  // Scalar keys: binary search vs. key index.
+  flatbuffers::FlatBufferBuilder counters_fbb;
+  std::vector<flatbuffers::Offset<KeyTest::Counter>> counters;
+  for (int i = 0; i < kNumKeys; i++) {
+    counters.push_back(KeyTest::CreateCounter(counters_fbb,
+                         static_cast<uint16_t>(i),
+                         counters_fbb.CreateString(names[i])));
+  }
+  auto counters_vec = counters_fbb.CreateVectorOfSortedTables(&counters);
+  auto key_index = counters_fbb.CreateKeyIndex(counters);
+  counters_fbb.Finish(KeyTest::CreateCounters(counters_fbb, counters_vec,
+                                              key_index));
+  auto counters_root = flatbuffers::GetRoot<KeyTest::Counters>(
+                         counters_fbb.GetBufferPointer());
+  Time("LookupByKey, ushort, binary search", kNumKeys, [&]() {
+    for (int i = 0; i < kNumKeys; i++) {
+      sink += counters_root->counters()->LookupByKey(
+                static_cast<uint16_t>(i)) != nullptr;
+    }
+  });
+  Time("LookupByKey, ushort, key index", kNumKeys, [&]() {
+    for (int i = 0; i < kNumKeys; i++)
+      sink += counters_root->counters_by_key(static_cast<uint16_t>(i)) !=
+              nullptr;
+  });
+}
+
+int main(int /*argc*/, const char * /*argv*/[]) {
+  VTableDedupBenchmark();
+  VectorBenchmark();
+  SegmentedBenchmark();
+  PoolBenchmark();
+  SharedStringBenchmark();
+  LookupBenchmark();
+  return 0;
+}
@@ -1,2 +1,3 @@
-../flatc --cpp --java --csharp --go --binary --python --js --php --gen-mutable --no-includes monster_test.fbs monsterdata_test.json
+../flatc --cpp --java --csharp --go --binary --python --js --php --gen-mutable --gen-bounds-checked --no-includes monster_test.fbs monsterdata_test.json
 ../flatc --binary --schema monster_test.fbs
+../flatc --cpp --gen-mutable --no-includes key_test.fbs
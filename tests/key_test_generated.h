@@ -0,0 +1,282 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_KEYTEST_KEYTEST_H_
+#define FLATBUFFERS_GENERATED_KEYTEST_KEYTEST_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+
+namespace KeyTest {
+
+struct Reading;
+struct Readings;
+struct Entry;
+struct Entries;
+struct Counter;
+struct Counters;
+
+struct Reading FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_VALUE = 4,
+  };
+  double value() const { return GetField<double>(VT_VALUE, 0); }
+  bool mutate_value(double _value) { return SetField(VT_VALUE, _value); }
+  bool KeyCompareLessThan(const Reading *o) const { return value() < o->value(); }
+  int KeyCompareWithValue(double val) const { return value() < val ? -1 : value() > val; }
+  uint32_t KeyHash() const { return KeyHashValue(value()); }
+  static uint32_t KeyHashValue(double val) { return flatbuffers::HashKey(val); }
+  uint64_t KeyPrefix() const { return KeyPrefixValue(value()); }
+  static uint64_t KeyPrefixValue(double val) { return flatbuffers::KeyPrefix(val); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<double>(verifier, VT_VALUE) &&
+           verifier.EndTable();
+  }
+};
+
+struct ReadingBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_value(double value) { fbb_.AddElement<double>(Reading::VT_VALUE, value, 0); }
+  ReadingBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  ReadingBuilder &operator=(const ReadingBuilder &);
+  flatbuffers::Offset<Reading> Finish() {
+    auto o = flatbuffers::Offset<Reading>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Reading> CreateReading(flatbuffers::FlatBufferBuilder &_fbb,
+   double value = 0) {
+  ReadingBuilder builder_(_fbb);
+  builder_.add_value(value);
+  return builder_.Finish();
+}
+
+struct Readings FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_READINGS = 4,
+    VT_READINGS_INDEX = 6,
+  };
+  const flatbuffers::Vector<flatbuffers::Offset<Reading>> *readings() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Reading>> *>(VT_READINGS); }
+  flatbuffers::Vector<flatbuffers::Offset<Reading>> *mutable_readings() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Reading>> *>(VT_READINGS); }
+  const flatbuffers::Vector<uint32_t> *readings_index() const { return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_READINGS_INDEX); }
+  flatbuffers::Vector<uint32_t> *mutable_readings_index() { return GetPointer<flatbuffers::Vector<uint32_t> *>(VT_READINGS_INDEX); }
+  const Reading *readings_by_key(double val) const { auto vec = readings(); return vec ? vec->LookupByKey(val, readings_index()) : nullptr; }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_READINGS) &&
+           verifier.Verify(readings()) &&
+           verifier.VerifyVectorOfTables(readings()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_READINGS_INDEX) &&
+           verifier.Verify(readings_index()) &&
+           verifier.EndTable();
+  }
+};
+
+struct ReadingsBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_readings(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Reading>>> readings) { fbb_.AddOffset(Readings::VT_READINGS, readings); }
+  void add_readings_index(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> readings_index) { fbb_.AddOffset(Readings::VT_READINGS_INDEX, readings_index); }
+  ReadingsBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  ReadingsBuilder &operator=(const ReadingsBuilder &);
+  flatbuffers::Offset<Readings> Finish() {
+    auto o = flatbuffers::Offset<Readings>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Readings> CreateReadings(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Reading>>> readings = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint32_t>> readings_index = 0) {
+  ReadingsBuilder builder_(_fbb);
+  builder_.add_readings_index(readings_index);
+  builder_.add_readings(readings);
+  return builder_.Finish();
+}
+
+struct Entry FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_NAME = 4,
+  };
+  const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(VT_NAME); }
+  flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(VT_NAME); }
+  bool KeyCompareLessThan(const Entry *o) const { return *name() < *o->name(); }
+  int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint32_t KeyHash() const { return KeyHashValue(name()->c_str()); }
+  static uint32_t KeyHashValue(const char *val) { return flatbuffers::HashKey(val); }
+  uint64_t KeyPrefix() const { return KeyPrefixValue(name()->c_str()); }
+  static uint64_t KeyPrefixValue(const char *val) { return flatbuffers::KeyPrefix(val); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyFieldRequired<flatbuffers::uoffset_t>(verifier, VT_NAME) &&
+           verifier.Verify(name()) &&
+           verifier.EndTable();
+  }
+};
+
+struct EntryBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_name(flatbuffers::Offset<flatbuffers::String> name) { fbb_.AddOffset(Entry::VT_NAME, name); }
+  EntryBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  EntryBuilder &operator=(const EntryBuilder &);
+  flatbuffers::Offset<Entry> Finish() {
+    auto o = flatbuffers::Offset<Entry>(fbb_.EndTable(start_, 1));
+    fbb_.Required(o, Entry::VT_NAME);  // name
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Entry> CreateEntry(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::String> name = 0) {
+  EntryBuilder builder_(_fbb);
+  builder_.add_name(name);
+  return builder_.Finish();
+}
+
+struct Entries FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_ENTRIES = 4,
+    VT_ENTRIES_INDEX = 6,
+  };
+  const flatbuffers::Vector<flatbuffers::Offset<Entry>> *entries() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Entry>> *>(VT_ENTRIES); }
+  flatbuffers::Vector<flatbuffers::Offset<Entry>> *mutable_entries() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Entry>> *>(VT_ENTRIES); }
+  const flatbuffers::Vector<uint32_t> *entries_index() const { return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_ENTRIES_INDEX); }
+  flatbuffers::Vector<uint32_t> *mutable_entries_index() { return GetPointer<flatbuffers::Vector<uint32_t> *>(VT_ENTRIES_INDEX); }
+  const Entry *entries_by_key(const char *val) const { auto vec = entries(); return vec ? vec->LookupByKey(val, entries_index()) : nullptr; }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_ENTRIES) &&
+           verifier.Verify(entries()) &&
+           verifier.VerifyVectorOfTables(entries()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_ENTRIES_INDEX) &&
+           verifier.Verify(entries_index()) &&
+           verifier.EndTable();
+  }
+};
+
+struct EntriesBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_entries(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Entry>>> entries) { fbb_.AddOffset(Entries::VT_ENTRIES, entries); }
+  void add_entries_index(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> entries_index) { fbb_.AddOffset(Entries::VT_ENTRIES_INDEX, entries_index); }
+  EntriesBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  EntriesBuilder &operator=(const EntriesBuilder &);
+  flatbuffers::Offset<Entries> Finish() {
+    auto o = flatbuffers::Offset<Entries>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Entries> CreateEntries(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Entry>>> entries = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint32_t>> entries_index = 0) {
+  EntriesBuilder builder_(_fbb);
+  builder_.add_entries_index(entries_index);
+  builder_.add_entries(entries);
+  return builder_.Finish();
+}
+
+struct Counter FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_COUNT = 4,
+    VT_NAME = 6,
+  };
+  uint16_t count() const { return GetField<uint16_t>(VT_COUNT, 0); }
+  bool mutate_count(uint16_t _count) { return SetField(VT_COUNT, _count); }
+  bool KeyCompareLessThan(const Counter *o) const { return count() < o->count(); }
+  int KeyCompareWithValue(uint16_t val) const { return count() < val ? -1 : count() > val; }
+  uint32_t KeyHash() const { return KeyHashValue(count()); }
+  static uint32_t KeyHashValue(uint16_t val) { return flatbuffers::HashKey(val); }
+  uint64_t KeyPrefix() const { return KeyPrefixValue(count()); }
+  static uint64_t KeyPrefixValue(uint16_t val) { return flatbuffers::KeyPrefix(val); }
+  const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(VT_NAME); }
+  flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(VT_NAME); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint16_t>(verifier, VT_COUNT) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_NAME) &&
+           verifier.Verify(name()) &&
+           verifier.EndTable();
+  }
+};
+
+struct CounterBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_count(uint16_t count) { fbb_.AddElement<uint16_t>(Counter::VT_COUNT, count, 0); }
+  void add_name(flatbuffers::Offset<flatbuffers::String> name) { fbb_.AddOffset(Counter::VT_NAME, name); }
+  CounterBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  CounterBuilder &operator=(const CounterBuilder &);
+  flatbuffers::Offset<Counter> Finish() {
+    auto o = flatbuffers::Offset<Counter>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Counter> CreateCounter(flatbuffers::FlatBufferBuilder &_fbb,
+   uint16_t count = 0,
+   flatbuffers::Offset<flatbuffers::String> name = 0) {
+  CounterBuilder builder_(_fbb);
+  builder_.add_name(name);
+  builder_.add_count(count);
+  return builder_.Finish();
+}
+
+struct Counters FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_COUNTERS = 4,
+    VT_COUNTERS_INDEX = 6,
+  };
+  const flatbuffers::Vector<flatbuffers::Offset<Counter>> *counters() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Counter>> *>(VT_COUNTERS); }
+  flatbuffers::Vector<flatbuffers::Offset<Counter>> *mutable_counters() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Counter>> *>(VT_COUNTERS); }
+  const flatbuffers::Vector<uint64_t> *counters_index() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_COUNTERS_INDEX); }
+  flatbuffers::Vector<uint64_t> *mutable_counters_index() { return GetPointer<flatbuffers::Vector<uint64_t> *>(VT_COUNTERS_INDEX); }
+  const Counter *counters_by_key(uint16_t val) const { auto vec = counters(); return vec ? vec->LookupByKey(val, counters_index()) : nullptr; }
+  flatbuffers::uoffset_t counters_lower_bound(uint16_t val) const { auto vec = counters(); return vec ? vec->LowerBoundByKey(val, counters_index()) : 0; }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_COUNTERS) &&
+           verifier.Verify(counters()) &&
+           verifier.VerifyVectorOfTables(counters()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_COUNTERS_INDEX) &&
+           verifier.Verify(counters_index()) &&
+           verifier.EndTable();
+  }
+};
+
+struct CountersBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_counters(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Counter>>> counters) { fbb_.AddOffset(Counters::VT_COUNTERS, counters); }
+  void add_counters_index(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> counters_index) { fbb_.AddOffset(Counters::VT_COUNTERS_INDEX, counters_index); }
+  CountersBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  CountersBuilder &operator=(const CountersBuilder &);
+  flatbuffers::Offset<Counters> Finish() {
+    auto o = flatbuffers::Offset<Counters>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Counters> CreateCounters(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Counter>>> counters = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint64_t>> counters_index = 0) {
+  CountersBuilder builder_(_fbb);
+  builder_.add_counters_index(counters_index);
+  builder_.add_counters(counters);
+  return builder_.Finish();
+}
+
+inline const KeyTest::Readings *GetReadings(const void *buf) { return flatbuffers::GetRoot<KeyTest::Readings>(buf); }
+
+inline Readings *GetMutableReadings(void *buf) { return flatbuffers::GetMutableRoot<Readings>(buf); }
+
+inline bool VerifyReadingsBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<KeyTest::Readings>(); }
+
+inline void FinishReadingsBuffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<KeyTest::Readings> root) { fbb.Finish(root); }
+
+}  // namespace KeyTest
+
+#endif  // FLATBUFFERS_GENERATED_KEYTEST_KEYTEST_H_
@@ -101,6 +101,7 @@ struct TestSimpleTableWithEnum FLATBUFFERS_FINAL_CLASS : private flatbuffers::Ta
     VT_COLOR = 4,
   };
   Color color() const { return static_cast<Color>(GetField<int8_t>(VT_COLOR, 2)); }
+  Color color(const flatbuffers::Verifier &verifier) const { return static_cast<Color>(GetFieldChecked<int8_t>(verifier, VT_COLOR, 2)); }
   bool mutate_color(Color _color) { return SetField(VT_COLOR, static_cast<int8_t>(_color)); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
@@ -135,10 +136,13 @@ struct Stat FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_COUNT = 8,
   };
   const flatbuffers::String *id() const { return GetPointer<const flatbuffers::String *>(VT_ID); }
+  const flatbuffers::String *id(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::String *>(verifier, VT_ID); }
   flatbuffers::String *mutable_id() { return GetPointer<flatbuffers::String *>(VT_ID); }
   int64_t val() const { return GetField<int64_t>(VT_VAL, 0); }
+  int64_t val(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int64_t>(verifier, VT_VAL, 0); }
   bool mutate_val(int64_t _val) { return SetField(VT_VAL, _val); }
   uint16_t count() const { return GetField<uint16_t>(VT_COUNT, 0); }
+  uint16_t count(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<uint16_t>(verifier, VT_COUNT, 0); }
   bool mutate_count(uint16_t _count) { return SetField(VT_COUNT, _count); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
@@ -204,57 +208,85 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TESTARRAYOFBOOLS = 52,
   };
   const Vec3 *pos() const { return GetStruct<const Vec3 *>(VT_POS); }
+  const Vec3 *pos(const flatbuffers::Verifier &verifier) const { return GetStructChecked<const Vec3 *>(verifier, VT_POS); }
   Vec3 *mutable_pos() { return GetStruct<Vec3 *>(VT_POS); }
   int16_t mana() const { return GetField<int16_t>(VT_MANA, 150); }
+  int16_t mana(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int16_t>(verifier, VT_MANA, 150); }
   bool mutate_mana(int16_t _mana) { return SetField(VT_MANA, _mana); }
   int16_t hp() const { return GetField<int16_t>(VT_HP, 100); }
+  int16_t hp(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int16_t>(verifier, VT_HP, 100); }
   bool mutate_hp(int16_t _hp) { return SetField(VT_HP, _hp); }
   const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(VT_NAME); }
+  const flatbuffers::String *name(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::String *>(verifier, VT_NAME); }
   flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(VT_NAME); }
   bool KeyCompareLessThan(const Monster *o) const { return *name() < *o->name(); }
   int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint32_t KeyHash() const { return KeyHashValue(name()->c_str()); }
+  static uint32_t KeyHashValue(const char *val) { return flatbuffers::HashKey(val); }
+  uint64_t KeyPrefix() const { return KeyPrefixValue(name()->c_str()); }
+  static uint64_t KeyPrefixValue(const char *val) { return flatbuffers::KeyPrefix(val); }
   const flatbuffers::Vector<uint8_t> *inventory() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_INVENTORY); }
+  const flatbuffers::Vector<uint8_t> *inventory(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<uint8_t> *>(verifier, VT_INVENTORY); }
   flatbuffers::Vector<uint8_t> *mutable_inventory() { return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_INVENTORY); }
   Color color() const { return static_cast<Color>(GetField<int8_t>(VT_COLOR, 8)); }
+  Color color(const flatbuffers::Verifier &verifier) const { return static_cast<Color>(GetFieldChecked<int8_t>(verifier, VT_COLOR, 8)); }
   bool mutate_color(Color _color) { return SetField(VT_COLOR, static_cast<int8_t>(_color)); }
   Any test_type() const { return static_cast<Any>(GetField<uint8_t>(VT_TEST_TYPE, 0)); }
+  Any test_type(const flatbuffers::Verifier &verifier) const { return static_cast<Any>(GetFieldChecked<uint8_t>(verifier, VT_TEST_TYPE, 0)); }
   bool mutate_test_type(Any _test_type) { return SetField(VT_TEST_TYPE, static_cast<uint8_t>(_test_type)); }
   const void *test() const { return GetPointer<const void *>(VT_TEST); }
+  const void *test(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const void *>(verifier, VT_TEST); }
   void *mutable_test() { return GetPointer<void *>(VT_TEST); }
   const flatbuffers::Vector<const Test *> *test4() const { return GetPointer<const flatbuffers::Vector<const Test *> *>(VT_TEST4); }
+  const flatbuffers::Vector<const Test *> *test4(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<const Test *> *>(verifier, VT_TEST4); }
   flatbuffers::Vector<const Test *> *mutable_test4() { return GetPointer<flatbuffers::Vector<const Test *> *>(VT_TEST4); }
   const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *testarrayofstring() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_TESTARRAYOFSTRING); }
+  const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *testarrayofstring(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(verifier, VT_TESTARRAYOFSTRING); }
   flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *mutable_testarrayofstring() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_TESTARRAYOFSTRING); }
   /// an example documentation comment: this will end up in the generated code
   /// multiline too
   const flatbuffers::Vector<flatbuffers::Offset<Monster>> *testarrayoftables() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Monster>> *>(VT_TESTARRAYOFTABLES); }
+  const flatbuffers::Vector<flatbuffers::Offset<Monster>> *testarrayoftables(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<flatbuffers::Offset<Monster>> *>(verifier, VT_TESTARRAYOFTABLES); }
   flatbuffers::Vector<flatbuffers::Offset<Monster>> *mutable_testarrayoftables() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Monster>> *>(VT_TESTARRAYOFTABLES); }
   const Monster *enemy() const { return GetPointer<const Monster *>(VT_ENEMY); }
+  const Monster *enemy(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const Monster *>(verifier, VT_ENEMY); }
   Monster *mutable_enemy() { return GetPointer<Monster *>(VT_ENEMY); }
   const flatbuffers::Vector<uint8_t> *testnestedflatbuffer() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_TESTNESTEDFLATBUFFER); }
+  const flatbuffers::Vector<uint8_t> *testnestedflatbuffer(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<uint8_t> *>(verifier, VT_TESTNESTEDFLATBUFFER); }
   flatbuffers::Vector<uint8_t> *mutable_testnestedflatbuffer() { return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_TESTNESTEDFLATBUFFER); }
   const MyGame::Example::Monster *testnestedflatbuffer_nested_root() const { return flatbuffers::GetRoot<MyGame::Example::Monster>(testnestedflatbuffer()->Data()); }
   const Stat *testempty() const { return GetPointer<const Stat *>(VT_TESTEMPTY); }
+  const Stat *testempty(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const Stat *>(verifier, VT_TESTEMPTY); }
   Stat *mutable_testempty() { return GetPointer<Stat *>(VT_TESTEMPTY); }
   bool testbool() const { return static_cast<bool>(GetField<uint8_t>(VT_TESTBOOL, 0)); }
+  bool testbool(const flatbuffers::Verifier &verifier) const { return static_cast<bool>(GetFieldChecked<uint8_t>(verifier, VT_TESTBOOL, 0)); }
   bool mutate_testbool(bool _testbool) { return SetField(VT_TESTBOOL, static_cast<uint8_t>(_testbool)); }
   int32_t testhashs32_fnv1() const { return GetField<int32_t>(VT_TESTHASHS32_FNV1, 0); }
+  int32_t testhashs32_fnv1(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int32_t>(verifier, VT_TESTHASHS32_FNV1, 0); }
   bool mutate_testhashs32_fnv1(int32_t _testhashs32_fnv1) { return SetField(VT_TESTHASHS32_FNV1, _testhashs32_fnv1); }
   uint32_t testhashu32_fnv1() const { return GetField<uint32_t>(VT_TESTHASHU32_FNV1, 0); }
+  uint32_t testhashu32_fnv1(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<uint32_t>(verifier, VT_TESTHASHU32_FNV1, 0); }
   bool mutate_testhashu32_fnv1(uint32_t _testhashu32_fnv1) { return SetField(VT_TESTHASHU32_FNV1, _testhashu32_fnv1); }
   int64_t testhashs64_fnv1() const { return GetField<int64_t>(VT_TESTHASHS64_FNV1, 0); }
+  int64_t testhashs64_fnv1(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int64_t>(verifier, VT_TESTHASHS64_FNV1, 0); }
   bool mutate_testhashs64_fnv1(int64_t _testhashs64_fnv1) { return SetField(VT_TESTHASHS64_FNV1, _testhashs64_fnv1); }
   uint64_t testhashu64_fnv1() const { return GetField<uint64_t>(VT_TESTHASHU64_FNV1, 0); }
+  uint64_t testhashu64_fnv1(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<uint64_t>(verifier, VT_TESTHASHU64_FNV1, 0); }
   bool mutate_testhashu64_fnv1(uint64_t _testhashu64_fnv1) { return SetField(VT_TESTHASHU64_FNV1, _testhashu64_fnv1); }
   int32_t testhashs32_fnv1a() const { return GetField<int32_t>(VT_TESTHASHS32_FNV1A, 0); }
+  int32_t testhashs32_fnv1a(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int32_t>(verifier, VT_TESTHASHS32_FNV1A, 0); }
   bool mutate_testhashs32_fnv1a(int32_t _testhashs32_fnv1a) { return SetField(VT_TESTHASHS32_FNV1A, _testhashs32_fnv1a); }
   uint32_t testhashu32_fnv1a() const { return GetField<uint32_t>(VT_TESTHASHU32_FNV1A, 0); }
+  uint32_t testhashu32_fnv1a(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<uint32_t>(verifier, VT_TESTHASHU32_FNV1A, 0); }
   bool mutate_testhashu32_fnv1a(uint32_t _testhashu32_fnv1a) { return SetField(VT_TESTHASHU32_FNV1A, _testhashu32_fnv1a); }
   int64_t testhashs64_fnv1a() const { return GetField<int64_t>(VT_TESTHASHS64_FNV1A, 0); }
+  int64_t testhashs64_fnv1a(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<int64_t>(verifier, VT_TESTHASHS64_FNV1A, 0); }
   bool mutate_testhashs64_fnv1a(int64_t _testhashs64_fnv1a) { return SetField(VT_TESTHASHS64_FNV1A, _testhashs64_fnv1a); }
   uint64_t testhashu64_fnv1a() const { return GetField<uint64_t>(VT_TESTHASHU64_FNV1A, 0); }
+  uint64_t testhashu64_fnv1a(const flatbuffers::Verifier &verifier) const { return GetFieldChecked<uint64_t>(verifier, VT_TESTHASHU64_FNV1A, 0); }
   bool mutate_testhashu64_fnv1a(uint64_t _testhashu64_fnv1a) { return SetField(VT_TESTHASHU64_FNV1A, _testhashu64_fnv1a); }
   const flatbuffers::Vector<uint8_t> *testarrayofbools() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_TESTARRAYOFBOOLS); }
+  const flatbuffers::Vector<uint8_t> *testarrayofbools(const flatbuffers::Verifier &verifier) const { return GetPointerChecked<const flatbuffers::Vector<uint8_t> *>(verifier, VT_TESTARRAYOFBOOLS); }
   flatbuffers::Vector<uint8_t> *mutable_testarrayofbools() { return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_TESTARRAYOFBOOLS); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
@@ -400,6 +432,8 @@ inline const MyGame::Example::Monster *GetMonster(const void *buf) { return flat
 
 inline Monster *GetMutableMonster(void *buf) { return flatbuffers::GetMutableRoot<Monster>(buf); }
 
+inline const MyGame::Example::Monster *GetMonsterChecked(const flatbuffers::Verifier &verifier) { return verifier.GetRootChecked<MyGame::Example::Monster>(); }
+
 inline bool VerifyMonsterBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<MyGame::Example::Monster>(); }
 
 inline const char *MonsterIdentifier() { return "MONS"; }
@@ -17,54 +17,29 @@
 #define FLATBUFFERS_DEBUG_VERIFICATION_FAILURE 1
 
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/arena.h"
+#include "flatbuffers/batch_verifier.h"
+#include "flatbuffers/buffer_io.h"
+#include "flatbuffers/builder_pool.h"
+#include "flatbuffers/convert_frames.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 
+#include "key_test_generated.h"
 #include "monster_test_generated.h"
+#include "test_assert.h"
 
+#include <cmath>
 #include <random>
+#include <set>
 
-using namespace MyGame::Example;
-
-#ifdef __ANDROID__
-  #include <android/log.h>
-  #define TEST_OUTPUT_LINE(...) \
-    __android_log_print(ANDROID_LOG_INFO, "FlatBuffers", __VA_ARGS__)
-  #define FLATBUFFERS_NO_FILE_TESTS
-#else
-  #define TEST_OUTPUT_LINE(...) \
-    { printf(__VA_ARGS__); printf("\n"); }
+#ifndef _WIN32
+  #include <sys/socket.h>
 #endif
 
-int testing_fails = 0;
-
-void TestFail(const char *expval, const char *val, const char *exp,
-              const char *file, int line) {
-  TEST_OUTPUT_LINE("TEST FAILED: %s:%d, %s (%s) != %s", file, line,
-                   exp, expval, val);
-  assert(0);
-  testing_fails++;
-}
-
-void TestEqStr(const char *expval, const char *val, const char *exp,
-               const char *file, int line) {
-  if (strcmp(expval, val) != 0) {
-    TestFail(expval, val, exp, file, line);
-  }
-}
-
-template<typename T, typename U>
-void TestEq(T expval, U val, const char *exp, const char *file, int line) {
-  if (U(expval) != val) {
-    TestFail(flatbuffers::NumToString(expval).c_str(),
-             flatbuffers::NumToString(val).c_str(),
-             exp, file, line);
-  }
-}
+using namespace MyGame::Example;
 
-#define TEST_EQ(exp, val) TestEq(exp,         val,   #exp, __FILE__, __LINE__)
-#define TEST_NOTNULL(exp) TestEq(exp == NULL, false, #exp, __FILE__, __LINE__)
-#define TEST_EQ_STR(exp, val) TestEqStr(exp,  val,   #exp, __FILE__, __LINE__)
+int testing_fails = 0;
 
 // Include simple random number generator to ensure results will be the
 // same cross platform.
@@ -416,6 +391,584 @@ void ReflectionTest(uint8_t *flatbuf, size_t length) {
   AccessFlatBufferTest(fbb.GetBufferPointer(), fbb.GetSize());
 }
 
+void MutationTransactionTest(uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto fields = schema.root_table()->fields();
+  auto &name_field = *fields->LookupByKey("name");
+  auto &inventory_field = *fields->LookupByKey("inventory");
+  auto &testarrayofstring_field = *fields->LookupByKey("testarrayofstring");
+  typedef flatbuffers::Offset<flatbuffers::String> StringOffset;
+
+  // Make several edits in one go.
+  std::vector<uint8_t> batchbuf(flatbuf, flatbuf + length);
+  auto root = flatbuffers::GetAnyRoot(batchbuf.data());
+  auto name = flatbuffers::GetFieldS(*root, name_field);
+  auto name_offset = static_cast<flatbuffers::uoffset_t>(
+    reinterpret_cast<const uint8_t *>(name) - batchbuf.data());
+  auto strings = flatbuffers::GetFieldV<StringOffset>(*root,
+                                                      testarrayofstring_field);
+  flatbuffers::MutationTransaction transaction(schema, &batchbuf);
+  transaction.SetString(name, "replaced below");
+  transaction.SetString(name, "totally new string");
+  transaction.SetString(strings->Get(0), "b");
+  transaction.SetString(strings->Get(1), "a much longer string than fred");
+  transaction.ResizeVector<uint8_t>(
+    flatbuffers::GetFieldV<uint8_t>(*root, inventory_field), 110, 50);
+  TEST_EQ(transaction.size(), 5U);
+  transaction.Commit();
+  TEST_EQ(transaction.size(), 0U);
+  flatbuffers::Verifier verifier(batchbuf.data(), batchbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  auto monster = GetMonster(batchbuf.data());
+  TEST_EQ_STR(monster->name()->c_str(), "totally new string");
+  TEST_EQ(reinterpret_cast<const uint8_t *>(monster->name()) - batchbuf.data(),
+          transaction.Remap(name_offset));
+  TEST_EQ_STR(monster->testarrayofstring()->Get(0)->c_str(), "b");
+  TEST_EQ_STR(monster->testarrayofstring()->Get(1)->c_str(),
+              "a much longer string than fred");
+  TEST_EQ(monster->inventory()->size(), 110U);
+  TEST_EQ(monster->inventory()->Get(9), 9);
+  TEST_EQ(monster->inventory()->Get(109), 50);
+
+  // The same edits one at a time give the same buffer.
+  std::vector<uint8_t> seqbuf(flatbuf, flatbuf + length);
+  // Each edit may reallocate seqbuf, so get the root again for the next one.
+  auto seq_root = [&seqbuf]() -> flatbuffers::Table & {
+    return *flatbuffers::GetAnyRoot(seqbuf.data());
+  };
+  flatbuffers::SetString(schema, "totally new string",
+                         flatbuffers::GetFieldS(seq_root(), name_field),
+                         &seqbuf);
+  flatbuffers::SetString(schema, "b",
+                         flatbuffers::GetFieldV<StringOffset>(
+                           seq_root(), testarrayofstring_field)->Get(0),
+                         &seqbuf);
+  flatbuffers::SetString(schema, "a much longer string than fred",
+                         flatbuffers::GetFieldV<StringOffset>(
+                           seq_root(), testarrayofstring_field)->Get(1),
+                         &seqbuf);
+  flatbuffers::ResizeVector<uint8_t>(schema, 110, 50,
+                                     flatbuffers::GetFieldV<uint8_t>(
+                                       seq_root(), inventory_field),
+                                     &seqbuf);
+  TEST_EQ(seqbuf == batchbuf, true);
+
+  // Shrinking removes the end of the vector.
+  flatbuffers::ResizeVector<uint8_t>(schema, 3, 0, monster->inventory(),
+                                     &batchbuf);
+  flatbuffers::Verifier shrunk_verifier(batchbuf.data(), batchbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(shrunk_verifier), true);
+  monster = GetMonster(batchbuf.data());
+  TEST_EQ(monster->inventory()->size(), 3U);
+  TEST_EQ(monster->inventory()->Get(2), 2);
+  TEST_EQ_STR(monster->testarrayofstring()->Get(1)->c_str(),
+              "a much longer string than fred");
+
+  // Many edits spread over a bigger buffer.
+  const int kNumMonsters = 1000;
+  flatbuffers::FlatBufferBuilder fbb;
+  std::vector<flatbuffers::Offset<Monster>> monsters;
+  for (int i = 0; i < kNumMonsters; i++) {
+    monsters.push_back(CreateMonster(fbb, nullptr, 150, 80,
+      fbb.CreateString("monster" + flatbuffers::NumToString(i))));
+  }
+  auto vec = fbb.CreateVector(monsters);
+  auto root_name = fbb.CreateString("root");
+  MonsterBuilder mb(fbb);
+  mb.add_name(root_name);
+  mb.add_testarrayoftables(vec);
+  FinishMonsterBuffer(fbb, mb.Finish());
+  std::vector<uint8_t> bigbuf(fbb.GetBufferPointer(),
+                              fbb.GetBufferPointer() + fbb.GetSize());
+  auto tables = GetMonster(bigbuf.data())->testarrayoftables();
+  flatbuffers::MutationTransaction big_transaction(schema, &bigbuf);
+  for (int i = 0; i < kNumMonsters; i++) {
+    big_transaction.SetString(tables->Get(i)->name(),
+                              i % 2 ? "m" : std::string(i % 50, 'x'));
+  }
+  big_transaction.Commit();
+  flatbuffers::Verifier big_verifier(bigbuf.data(), bigbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(big_verifier), true);
+  tables = GetMonster(bigbuf.data())->testarrayoftables();
+  for (int i = 0; i < kNumMonsters; i++) {
+    TEST_EQ_STR(tables->Get(i)->name()->c_str(),
+                (i % 2 ? "m" : std::string(i % 50, 'x')).c_str());
+  }
+  TEST_EQ_STR(GetMonster(bigbuf.data())->name()->c_str(), "root");
+}
+
+void TableCopierTest(uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root = *flatbuffers::GetAnyRoot(flatbuf);
+
+  // Copies exactly the same as CopyTable, each time it is used.
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(flatbuffers::CopyTable(fbb, schema, *schema.root_table(), root));
+  flatbuffers::TableCopier copier(schema);
+  for (int i = 0; i < 3; i++) {
+    flatbuffers::FlatBufferBuilder copierfbb;
+    copierfbb.Finish(copier.CopyTable(copierfbb, *schema.root_table(), root));
+    TEST_EQ(copierfbb.GetSize(), fbb.GetSize());
+    TEST_EQ(memcmp(copierfbb.GetBufferPointer(), fbb.GetBufferPointer(),
+                   fbb.GetSize()), 0);
+    flatbuffers::Verifier verifier(copierfbb.GetBufferPointer(),
+                                   copierfbb.GetSize());
+    TEST_EQ(VerifyMonsterBuffer(verifier), true);
+    auto monster = GetMonster(copierfbb.GetBufferPointer());
+    TEST_EQ_STR(monster->name()->c_str(), "MyMonster");
+    TEST_EQ(monster->test_type(), Any_Monster);
+  }
+
+  // Or with an index shared with other code.
+  flatbuffers::SchemaIndex index(schema);
+  flatbuffers::TableCopier indexcopier(schema, &index);
+  flatbuffers::FlatBufferBuilder indexfbb;
+  indexfbb.Finish(indexcopier.CopyTable(indexfbb, *schema.root_table(), root));
+  TEST_EQ(indexfbb.GetSize(), fbb.GetSize());
+  TEST_EQ(memcmp(indexfbb.GetBufferPointer(), fbb.GetBufferPointer(),
+                 fbb.GetSize()), 0);
+
+  // Vectors of structs whose size isn't a power of 2 are aligned to the
+  // struct's alignment, so copies come out the same size as the original
+  // (rather than padded as if aligned to the struct's size).
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("struct Triple { a:int; b:int; c:int; }"
+                       "table Root { name:string; triples:[Triple]; }"
+                       "root_type Root;"), true);
+  parser.Serialize();
+  std::string triple_bfbs(
+    reinterpret_cast<const char *>(parser.builder_.GetBufferPointer()),
+    parser.builder_.GetSize());
+  auto &triple_schema = *reflection::GetSchema(triple_bfbs.c_str());
+  flatbuffers::TableCopier triple_copier(triple_schema);
+  const char *triple_json[] = {
+    "{ name: \"one\", triples: [ { a: 1, b: 2, c: 3 } ] }",
+    "{ name: \"two\","
+    "  triples: [ { a: 1, b: 2, c: 3 }, { a: 4, b: 5, c: 6 } ] }",
+    "{ triples: [ { a: 1, b: 2, c: 3 }, { a: 4, b: 5, c: 6 },"
+    "             { a: 7, b: 8, c: 9 } ] }"
+  };
+  for (size_t i = 0; i < sizeof(triple_json) / sizeof(triple_json[0]); i++) {
+    TEST_EQ(parser.Parse(triple_json[i]), true);
+    auto &triple_root = *flatbuffers::GetAnyRoot(
+                           parser.builder_.GetBufferPointer());
+    flatbuffers::FlatBufferBuilder copyfbb;
+    copyfbb.Finish(flatbuffers::CopyTable(copyfbb, triple_schema,
+                                          *triple_schema.root_table(),
+                                          triple_root));
+    TEST_EQ(copyfbb.GetSize(), parser.builder_.GetSize());
+    flatbuffers::FlatBufferBuilder copierfbb;
+    copierfbb.Finish(triple_copier.CopyTable(copierfbb,
+                                             *triple_schema.root_table(),
+                                             triple_root));
+    TEST_EQ(copierfbb.GetSize(), parser.builder_.GetSize());
+  }
+}
+
+void SchemaIndexTest(uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  flatbuffers::SchemaIndex index(schema);
+
+  // Finds the same objects and fields as the schema itself.
+  auto objects = schema.objects();
+  for (auto it = objects->begin(); it != objects->end(); ++it) {
+    auto &objectdef = **it;
+    TEST_EQ(index.LookupObject(objectdef.name()->c_str()), &objectdef);
+    TEST_EQ(objects->Get(static_cast<flatbuffers::uoffset_t>(
+              index.GetObjectIndex(objectdef))), &objectdef);
+    auto fields = objectdef.fields();
+    for (auto fit = fields->begin(); fit != fields->end(); ++fit) {
+      auto &fielddef = **fit;
+      TEST_EQ(index.LookupField(objectdef, fielddef.name()->c_str()),
+              fields->LookupByKey(fielddef.name()->c_str()));
+      auto type = fielddef.type();
+      TEST_EQ(index.GetTypeSizeInline(type->base_type(), type->index()),
+              flatbuffers::GetTypeSizeInline(type->base_type(), type->index(),
+                                             schema));
+    }
+  }
+  auto monsterdef = index.LookupObject("Monster");
+  TEST_EQ(monsterdef, schema.root_table());
+  TEST_NOTNULL(index.LookupField(*monsterdef, "hp"));
+  TEST_EQ(index.LookupField(*monsterdef, "hpx") == nullptr, true);
+  TEST_EQ(index.LookupField(*index.LookupObject("Vec3"), "hp") == nullptr,
+          true);
+  TEST_EQ(index.LookupObject("Monster2") == nullptr, true);
+
+  // Unions.
+  auto &root = *flatbuffers::GetAnyRoot(flatbuf);
+  auto &test_field = *index.LookupField(*monsterdef, "test");
+  TEST_EQ(index.GetUnionTypeField(test_field),
+          index.LookupField(*monsterdef, "test_type"));
+  TEST_EQ(index.GetUnionTypeField(*index.LookupField(*monsterdef, "hp")) ==
+          nullptr, true);
+  TEST_EQ(&index.GetUnionType(test_field, root),
+          &flatbuffers::GetUnionType(schema, *monsterdef, test_field, root));
+  TEST_EQ(&index.GetUnionType(test_field, root), monsterdef);
+
+  // Can be used by other reflection functions.
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(flatbuffers::CopyTable(fbb, schema, *monsterdef, root));
+  flatbuffers::FlatBufferBuilder indexfbb;
+  indexfbb.Finish(flatbuffers::CopyTable(indexfbb, schema, *monsterdef, root,
+                                         &index));
+  TEST_EQ(indexfbb.GetSize(), fbb.GetSize());
+  TEST_EQ(memcmp(indexfbb.GetBufferPointer(), fbb.GetBufferPointer(),
+                 fbb.GetSize()), 0);
+  std::vector<uint8_t> resizingbuf(flatbuf, flatbuf + length);
+  flatbuffers::SetString(schema, "a new name with a union",
+                         GetMonster(resizingbuf.data())->name(), &resizingbuf,
+                         nullptr, &index);
+  flatbuffers::Verifier verifier(resizingbuf.data(), resizingbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ_STR(GetMonster(resizingbuf.data())->name()->c_str(),
+              "a new name with a union");
+}
+
+void FieldHandleTest(uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root = *flatbuffers::GetAnyRoot(flatbuf);
+  flatbuffers::SchemaIndex index(schema);
+
+  // Reads every field the same as the generic functions, whether present or
+  // not.
+  auto fields = schema.root_table()->fields();
+  for (auto it = fields->begin(); it != fields->end(); ++it) {
+    auto &fielddef = **it;
+    flatbuffers::FieldHandle handle(fielddef, &schema);
+    flatbuffers::FieldHandle indexhandle(fielddef, index);
+    TEST_EQ(handle.offset(), fielddef.offset());
+    TEST_EQ(handle.GetI(root), flatbuffers::GetAnyFieldI(root, fielddef));
+    TEST_EQ(handle.GetF(root), flatbuffers::GetAnyFieldF(root, fielddef));
+    TEST_EQ_STR(handle.GetS(root).c_str(),
+                flatbuffers::GetAnyFieldS(root, fielddef, &schema).c_str());
+    TEST_EQ_STR(indexhandle.GetS(root).c_str(), handle.GetS(root).c_str());
+  }
+  auto &vec3def = *schema.objects()->LookupByKey("Vec3");
+  auto &pos = *root.GetStruct<const flatbuffers::Struct *>(
+    fields->LookupByKey("pos")->offset());
+  for (auto it = vec3def.fields()->begin(); it != vec3def.fields()->end();
+       ++it) {
+    auto &fielddef = **it;
+    flatbuffers::FieldHandle handle(fielddef);
+    TEST_EQ(handle.GetI(pos), flatbuffers::GetAnyFieldI(pos, fielddef));
+    TEST_EQ(handle.GetF(pos), flatbuffers::GetAnyFieldF(pos, fielddef));
+    TEST_EQ_STR(handle.GetS(pos).c_str(),
+                flatbuffers::GetAnyFieldS(pos, fielddef).c_str());
+  }
+
+  // Writes.
+  std::vector<uint8_t> buf(flatbuf, flatbuf + length);
+  auto &mutable_root = *flatbuffers::GetAnyRoot(buf.data());
+  auto monster = GetMonster(buf.data());
+  flatbuffers::FieldHandle hp(*fields->LookupByKey("hp"));
+  TEST_EQ(hp.SetI(&mutable_root, 300), true);
+  TEST_EQ(monster->hp(), 300);
+  TEST_EQ(hp.SetF(&mutable_root, 301.5), true);
+  TEST_EQ(monster->hp(), 301);
+  TEST_EQ(hp.SetS(&mutable_root, "302"), true);
+  TEST_EQ(monster->hp(), 302);
+  flatbuffers::FieldHandle mana(*fields->LookupByKey("mana"));
+  TEST_EQ(mana.SetI(&mutable_root, 10), false);  // Not present.
+  TEST_EQ(mana.GetI(mutable_root), 150);
+  flatbuffers::FieldHandle z(*vec3def.fields()->LookupByKey("z"));
+  auto &mutable_pos = *mutable_root.GetStruct<flatbuffers::Struct *>(
+    fields->LookupByKey("pos")->offset());
+  z.SetS(&mutable_pos, "4.5");
+  TEST_EQ(monster->pos()->z(), 4.5f);
+  z.SetI(&mutable_pos, 5);
+  TEST_EQ(monster->pos()->z(), 5.0f);
+  flatbuffers::FieldHandle name(*fields->LookupByKey("name"));
+  TEST_EQ(name.SetI(&mutable_root, 1), true);  // Does nothing.
+  TEST_EQ_STR(name.GetS(mutable_root).c_str(), "MyMonster");
+
+  // Unsigned 64-bit values of 2^63 and up read as negative, as they do with
+  // GetAnyFieldF and GetAnyFieldS.
+  flatbuffers::FlatBufferBuilder fbb;
+  auto u64name = fbb.CreateString("u64");
+  MonsterBuilder u64builder(fbb);
+  u64builder.add_name(u64name);
+  u64builder.add_testhashu64_fnv1(0xFFFFFFFFFFFFFFFEULL);
+  FinishMonsterBuffer(fbb, u64builder.Finish());
+  auto &u64root = *flatbuffers::GetAnyRoot(fbb.GetBufferPointer());
+  auto &u64def = *fields->LookupByKey("testhashu64_fnv1");
+  flatbuffers::FieldHandle u64(u64def);
+  TEST_EQ(u64.GetI(u64root), -2);
+  TEST_EQ(u64.GetF(u64root), -2.0);
+  TEST_EQ(u64.GetF(u64root), flatbuffers::GetAnyFieldF(u64root, u64def));
+  TEST_EQ_STR(u64.GetS(u64root).c_str(), "-2");
+  TEST_EQ_STR(u64.GetS(u64root).c_str(),
+              flatbuffers::GetAnyFieldS(u64root, u64def, &schema).c_str());
+}
+
+// Parse a schema, returning it in binary form.
+std::string ParseSchema(flatbuffers::Parser *parser, const char *schema) {
+  TEST_EQ(parser->Parse(schema), true);
+  parser->Serialize();
+  return std::string(
+    reinterpret_cast<const char *>(parser->builder_.GetBufferPointer()),
+    parser->builder_.GetSize());
+}
+
+// Convert a buffer to JSON, so we can compare buffers regardless of layout.
+std::string BufferToText(const flatbuffers::Parser &parser,
+                         const void *buf) {
+  std::string text;
+  flatbuffers::GeneratorOptions opts;
+  opts.indent_step = -1;
+  GenerateText(parser, buf, opts, &text);
+  return text;
+}
+
+void SchemaConverterTest() {
+  flatbuffers::Parser old_parser;
+  auto old_bfbs = ParseSchema(&old_parser,
+    "table Inner { a:short; s:string; }"
+    "table Other { x:int; }"
+    "table Gone { g:int; }"
+    "union Any { Inner, Other, Gone }"
+    "struct Pair { a:int; b:int; }"
+    "table Root {"
+    "  id:int (id:0);"
+    "  name:string (id:1);"
+    "  score:short = 10 (id:2);"
+    "  dropped:int (id:3);"
+    "  inner:Inner (id:4);"
+    "  list:[short] (id:5);"
+    "  inners:[Inner] (id:6);"
+    "  pair:Pair (id:7);"
+    "  any:Any (id:9);"
+    "  ratio:float (id:10);"
+    "  tags:[string] (id:11);"
+    "}"
+    "root_type Root;"
+    "file_identifier \"CNV1\";");
+  flatbuffers::Parser new_parser;
+  auto new_bfbs = ParseSchema(&new_parser,
+    "table Inner { a:int; s:string; extra:int = 7; }"
+    "table Other { x:long; }"
+    "union Any { Other, Inner }"
+    "struct Pair { a:int; b:int; }"
+    "table Root {"
+    "  id:long (id:0);"
+    "  title:string (id:1);"
+    "  score:int = 20 (id:2);"
+    "  dropped:int (id:3, deprecated);"
+    "  inner:Inner (id:4);"
+    "  list:[int] (id:5);"
+    "  inners:[Inner] (id:6);"
+    "  pair:Pair (id:7);"
+    "  any:Any (id:9);"
+    "  ratio:double (id:10);"
+    "  tags:[string] (id:11);"
+    "  added:int = 5 (id:12);"
+    "}"
+    "root_type Root;"
+    "file_identifier \"CNV2\";");
+  auto &old_schema = *reflection::GetSchema(old_bfbs.c_str());
+  auto &new_schema = *reflection::GetSchema(new_bfbs.c_str());
+
+  // Old data, and what we expect it to be after conversion.
+  const char *old_json[] = {
+    "{ id: 42, name: \"first\", dropped: 7, inner: { a: -3, s: \"in\" },"
+    "  list: [1, -2, 300], inners: [{ a: 1 }, { a: 2, s: \"two\" }],"
+    "  pair: { a: 5, b: 6 }, any_type: Inner, any: { a: 9 }, ratio: 0.5,"
+    "  tags: [\"x\", \"y\"] }",
+    // Relies on the old default of score, and sets it to the new one.
+    "{ name: \"second\", score: 20, any_type: Other, any: { x: 100000 } }",
+    // Has a union type the new schema doesn't have.
+    "{ name: \"third\", any_type: Gone, any: { g: 1 } }",
+  };
+  const char *new_json[] = {
+    "{ id: 42, title: \"first\", score: 10, inner: { a: -3, s: \"in\" },"
+    "  list: [1, -2, 300], inners: [{ a: 1 }, { a: 2, s: \"two\" }],"
+    "  pair: { a: 5, b: 6 }, any_type: Inner, any: { a: 9 }, ratio: 0.5,"
+    "  tags: [\"x\", \"y\"] }",
+    "{ title: \"second\", any_type: Other, any: { x: 100000 } }",
+    "{ title: \"third\", score: 10 }",
+  };
+  const int kNumBuffers = sizeof(old_json) / sizeof(old_json[0]);
+
+  flatbuffers::SchemaConverter converter(old_schema, new_schema);
+  TEST_EQ(converter.Compile(), true);
+  flatbuffers::SchemaConverter identity(old_schema, old_schema);
+  TEST_EQ(identity.Compile(), true);
+  std::string frames;  // The old buffers, size prefixed.
+  std::vector<std::string> expected;
+  for (int i = 0; i < kNumBuffers; i++) {
+    TEST_EQ(old_parser.Parse(old_json[i]), true);
+    auto buf = old_parser.builder_.GetBufferPointer();
+    auto len = old_parser.builder_.GetSize();
+    auto old_text = BufferToText(old_parser, buf);
+    flatbuffers::FlatBufferBuilder fbb;
+    TEST_EQ(converter.Convert(buf, len, &fbb), true);
+    TEST_EQ(flatbuffers::BufferHasIdentifier(fbb.GetBufferPointer(), "CNV2"),
+            true);
+    TEST_EQ(new_parser.Parse(new_json[i]), true);
+    expected.push_back(BufferToText(new_parser,
+                                    new_parser.builder_.GetBufferPointer()));
+    TEST_EQ_STR(BufferToText(new_parser, fbb.GetBufferPointer()).c_str(),
+                expected.back().c_str());
+    // Converting to the same schema changes nothing.
+    flatbuffers::FlatBufferBuilder same_fbb;
+    TEST_EQ(identity.Convert(buf, len, &same_fbb, true), true);
+    auto frame = same_fbb.GetBufferPointer();
+    TEST_EQ_STR(BufferToText(old_parser,
+                             frame + sizeof(flatbuffers::uoffset_t)).c_str(),
+                old_text.c_str());
+    frames.append(reinterpret_cast<const char *>(frame), same_fbb.GetSize());
+  }
+  // Buffers with the wrong file identifier are rejected.
+  flatbuffers::FlatBufferBuilder wrong_fbb;
+  TEST_EQ(converter.Convert(new_parser.builder_.GetBufferPointer(),
+                            new_parser.builder_.GetSize(), &wrong_fbb),
+          false);
+
+  // Vectors of structs whose size isn't a power of 2 are aligned to the
+  // struct's alignment, so come out the same size as the original.
+  flatbuffers::Parser triple_parser;
+  auto triple_bfbs = ParseSchema(&triple_parser,
+    "struct Triple { a:int; b:int; c:int; }"
+    "table Root { name:string; triples:[Triple]; }"
+    "root_type Root;");
+  auto &triple_schema = *reflection::GetSchema(triple_bfbs.c_str());
+  flatbuffers::SchemaConverter triples(triple_schema, triple_schema);
+  TEST_EQ(triples.Compile(), true);
+  TEST_EQ(triple_parser.Parse("{ triples: [ { a: 1, b: 2, c: 3 },"
+                              "             { a: 4, b: 5, c: 6 },"
+                              "             { a: 7, b: 8, c: 9 } ] }"), true);
+  flatbuffers::FlatBufferBuilder triple_fbb;
+  TEST_EQ(triples.Convert(triple_parser.builder_.GetBufferPointer(),
+                          triple_parser.builder_.GetSize(), &triple_fbb),
+          true);
+  TEST_EQ(triple_fbb.GetSize(), triple_parser.builder_.GetSize());
+
+  // Incompatible schemas.
+  flatbuffers::Parser narrow_parser;
+  auto narrow_bfbs = ParseSchema(&narrow_parser,
+    "table Root { id:short; } root_type Root;");
+  flatbuffers::SchemaConverter narrowing(old_schema,
+    *reflection::GetSchema(narrow_bfbs.c_str()));
+  TEST_EQ(narrowing.Compile(), false);
+  TEST_EQ_STR(narrowing.error().c_str(),
+              "can't convert Root.id (Int) to Root.id (Short)");
+  // A struct of the same size, but with a field of another type.
+  flatbuffers::Parser pair_parser;
+  auto pair_bfbs = ParseSchema(&pair_parser,
+    "struct Pair { a:int; b:float; }"
+    "table Root {"
+    "  id:int (id:0);"
+    "  d1:int (id:1, deprecated);"
+    "  d2:int (id:2, deprecated);"
+    "  d3:int (id:3, deprecated);"
+    "  d4:int (id:4, deprecated);"
+    "  d5:int (id:5, deprecated);"
+    "  d6:int (id:6, deprecated);"
+    "  pair:Pair (id:7);"
+    "}"
+    "root_type Root;");
+  flatbuffers::SchemaConverter pair_changed(old_schema,
+    *reflection::GetSchema(pair_bfbs.c_str()));
+  TEST_EQ(pair_changed.Compile(), false);
+  TEST_EQ_STR(pair_changed.error().c_str(),
+              "can't convert Root.pair (Obj) to Root.pair (Obj)");
+  flatbuffers::Parser short_parser;
+  auto short_bfbs = ParseSchema(&short_parser,
+    "table Root { id:short; new_name:string (required); } root_type Root;");
+  flatbuffers::SchemaConverter required(
+    *reflection::GetSchema(narrow_bfbs.c_str()),
+    *reflection::GetSchema(short_bfbs.c_str()));
+  TEST_EQ(required.Compile(), false);
+  TEST_EQ_STR(required.error().c_str(),
+              "new field is required: Root.new_name");
+
+  #ifndef FLATBUFFERS_NO_FILE_TESTS
+  // Convert a file of many buffers.
+  const int kRepeat = 100;
+  std::string in_file;
+  for (int i = 0; i < kRepeat; i++) in_file += frames;
+  // Plus one that can't be converted.
+  auto first_frame = reinterpret_cast<const uint8_t *>(frames.data());
+  flatbuffers::FlatBufferBuilder new_frame_fbb;
+  TEST_EQ(converter.Convert(first_frame + sizeof(flatbuffers::uoffset_t),
+                            flatbuffers::GetPrefixedSize(first_frame),
+                            &new_frame_fbb, true), true);
+  in_file.append(reinterpret_cast<const char *>(
+                   new_frame_fbb.GetBufferPointer()),
+                 new_frame_fbb.GetSize());
+  const char *in_path = "tests/convert_frames_in.tmp";
+  const char *out_path = "tests/convert_frames_out.tmp";
+  TEST_EQ(flatbuffers::SaveFile(in_path, in_file, true), true);
+  flatbuffers::ConvertStats stats;
+  TEST_EQ(flatbuffers::ConvertFrames(converter, in_path, out_path, &stats, 4,
+                                     16), true);
+  TEST_EQ(stats.num_frames, static_cast<size_t>(kNumBuffers * kRepeat));
+  TEST_EQ(stats.num_failed, 1U);
+  TEST_EQ(stats.bytes_in, in_file.size());
+  std::string out_file;
+  TEST_EQ(flatbuffers::LoadFile(out_path, true, &out_file), true);
+  TEST_EQ(stats.bytes_out, out_file.size());
+  flatbuffers::FrameReader reader(
+    reinterpret_cast<const uint8_t *>(out_file.data()), out_file.size());
+  size_t size;
+  size_t num_frames = 0;
+  while (auto frame = reader.Next(&size)) {
+    TEST_EQ_STR(BufferToText(new_parser, frame).c_str(),
+                expected[num_frames % kNumBuffers].c_str());
+    num_frames++;
+  }
+  TEST_EQ(reader.Error(), false);
+  TEST_EQ(num_frames, stats.num_frames);
+
+  // An empty frame in front (which can't be converted) moves all others by 4
+  // bytes, so frames that were aligned no longer are, and the other way
+  // around. This converts them all the same, with a pool reused for both
+  // files.
+  flatbuffers::WorkerPool pool(3);
+  std::string shifted_file(sizeof(flatbuffers::uoffset_t), '\0');
+  shifted_file += in_file;
+  TEST_EQ(flatbuffers::SaveFile(in_path, shifted_file, true), true);
+  flatbuffers::ConvertStats shifted_stats;
+  TEST_EQ(flatbuffers::ConvertFrames(converter, in_path, out_path,
+                                     &shifted_stats, pool, 7), true);
+  TEST_EQ(shifted_stats.num_frames, stats.num_frames);
+  TEST_EQ(shifted_stats.num_failed, 2U);
+  TEST_EQ(shifted_stats.bytes_in, shifted_file.size());
+  std::string shifted_out_file;
+  TEST_EQ(flatbuffers::LoadFile(out_path, true, &shifted_out_file), true);
+  TEST_EQ(shifted_out_file == out_file, true);
+  TEST_EQ(flatbuffers::SaveFile(in_path, in_file, true), true);
+  TEST_EQ(flatbuffers::ConvertFrames(converter, in_path, out_path,
+                                     &shifted_stats, pool, 7), true);
+  TEST_EQ(shifted_stats.num_frames, stats.num_frames);
+  TEST_EQ(flatbuffers::LoadFile(out_path, true, &shifted_out_file), true);
+  TEST_EQ(shifted_out_file == out_file, true);
+
+  // A truncated frame at the end still gets all frames before it written.
+  TEST_EQ(flatbuffers::SaveFile(in_path, in_file + frames.substr(0, 10), true),
+          true);
+  TEST_EQ(flatbuffers::ConvertFrames(converter, in_path, out_path,
+                                     &shifted_stats, pool, 7), false);
+  TEST_EQ(shifted_stats.num_frames, stats.num_frames);
+  TEST_EQ(flatbuffers::LoadFile(out_path, true, &shifted_out_file), true);
+  TEST_EQ(shifted_out_file == out_file, true);
+  remove(in_path);
+  remove(out_path);
+  #endif
+}
+
 // Parse a .proto schema, output as .fbs
 void ParseProtoTest() {
   // load the .proto and the golden file from disk
@@ -535,6 +1088,922 @@ void FuzzTest1() {
   }
 }
 
+// Builds many tables with different layouts, and checks tables with the same
+// layout share a vtable, both before and after the builder is reused.
+void VTableDedupTest() {
+  const int num_shapes = 4000;
+  const flatbuffers::voffset_t num_fields = 12;
+
+  flatbuffers::FlatBufferBuilder builder;
+  for (int iteration = 0; iteration < 2; iteration++) {
+    builder.Clear();
+    std::vector<flatbuffers::uoffset_t> objects;
+    // Generate every shape twice, in two separate passes.
+    for (int pass = 0; pass < 2; pass++) {
+      for (int i = 0; i < num_shapes; i++) {
+        auto start = builder.StartTable();
+        for (flatbuffers::voffset_t f = 0; f < num_fields; f++) {
+          if ((i + 1) & (1 << f))
+            builder.AddElement<int32_t>(flatbuffers::FieldIndexToOffset(f),
+                                        i, -1);
+        }
+        objects.push_back(builder.EndTable(start, num_fields));
+      }
+    }
+    builder.PreAlign<flatbuffers::largest_scalar_t>(0);
+    uint8_t *eob = builder.GetCurrentBufferPointer() + builder.GetSize();
+    auto vtable_of = [&](size_t i) {
+      return reinterpret_cast<flatbuffers::Table *>(eob - objects[i])->
+               GetVTable();
+    };
+    for (int i = 0; i < num_shapes; i++) {
+      TEST_EQ(vtable_of(i) == vtable_of(i + num_shapes), true);
+      if (i) TEST_EQ(vtable_of(i) == vtable_of(i - 1), false);
+      auto table = reinterpret_cast<flatbuffers::Table *>(eob - objects[i]);
+      auto f = 0;
+      while (!((i + 1) & (1 << f))) f++;
+      CompareTableFieldValue(table, flatbuffers::FieldIndexToOffset(f), i);
+    }
+  }
+}
+
+void SharedStringTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  for (int iteration = 0; iteration < 2; iteration++) {
+    builder.Clear();
+    // Repeated content maps onto the same offset, regardless of how it is
+    // passed in.
+    auto a = builder.CreateSharedString("host-1");
+    auto b = builder.CreateSharedString(std::string("host-1"));
+    auto c = builder.CreateSharedString("host-12", 6);
+    auto d = builder.CreateSharedString("host-2");
+    TEST_EQ(a.o, b.o);
+    TEST_EQ(a.o, c.o);
+    TEST_EQ(d.o == a.o, false);
+    // Plain CreateString never shares.
+    TEST_EQ(builder.CreateString("host-1").o == a.o, false);
+    // Many distinct strings (forcing the index to grow) stay shared.
+    std::vector<flatbuffers::Offset<flatbuffers::String>> first;
+    auto size_before = builder.GetSize();
+    for (int i = 0; i < 1000; i++)
+      first.push_back(builder.CreateSharedString("metric." +
+                                                 flatbuffers::NumToString(i)));
+    auto size_after = builder.GetSize();
+    for (int i = 999; i >= 0; i--) {
+      auto o = builder.CreateSharedString("metric." +
+                                          flatbuffers::NumToString(i));
+      TEST_EQ(o.o, first[i].o);
+    }
+    TEST_EQ(builder.GetSize(), size_after);
+    TEST_EQ(size_after > size_before, true);
+  }
+  // Once the limit is reached, new strings are stored but not shared,
+  // while the ones already in the pool still are.
+  builder.Clear();
+  builder.SetSharedStringLimit(1);
+  auto x1 = builder.CreateSharedString("x");
+  auto y1 = builder.CreateSharedString("y");
+  auto x2 = builder.CreateSharedString("x");
+  auto y2 = builder.CreateSharedString("y");
+  TEST_EQ(x1.o, x2.o);
+  TEST_EQ(y1.o == y2.o, false);
+  auto vec = builder.CreateVector(std::vector<flatbuffers::Offset<
+                                    flatbuffers::String>>({ x1, y1, x2, y2 }));
+  builder.Finish(vec);
+  auto strings = flatbuffers::GetRoot<flatbuffers::Vector<
+                   flatbuffers::Offset<flatbuffers::String>>>(
+                     builder.GetBufferPointer());
+  TEST_EQ(strings->size(), 4U);
+  TEST_EQ_STR(strings->Get(0)->c_str(), "x");
+  TEST_EQ_STR(strings->Get(1)->c_str(), "y");
+  TEST_EQ_STR(strings->Get(2)->c_str(), "x");
+  TEST_EQ_STR(strings->Get(3)->c_str(), "y");
+  TEST_EQ(strings->Get(0) == strings->Get(2), true);
+}
+
+// CreateVector writes scalars in bulk; check it produces the same bytes as
+// pushing the elements one at a time.
+template<typename T> void CheckScalarVector(const std::vector<T> &v) {
+  flatbuffers::FlatBufferBuilder bulk, single;
+  // Misalign the buffers first, to check padding is the same.
+  bulk.PushElement<uint8_t>(1);
+  single.PushElement<uint8_t>(1);
+  auto bulk_vec = bulk.CreateVector(v);
+  single.StartVector(v.size(), sizeof(T));
+  for (auto i = v.size(); i > 0; ) single.PushElement(v[--i]);
+  auto single_vec = single.EndVector(v.size());
+  bulk.Finish(bulk_vec);
+  single.Finish(flatbuffers::Offset<flatbuffers::Vector<T>>(single_vec));
+  TEST_EQ(bulk.GetSize(), single.GetSize());
+  TEST_EQ(memcmp(bulk.GetBufferPointer(), single.GetBufferPointer(),
+                 bulk.GetSize()), 0);
+  auto read = flatbuffers::GetRoot<flatbuffers::Vector<T>>(
+                bulk.GetBufferPointer());
+  TEST_EQ(read->size(), v.size());
+  for (flatbuffers::uoffset_t i = 0; i < read->size(); i++)
+    TEST_EQ(read->Get(i), v[i]);
+}
+
+void ScalarVectorTest() {
+  std::vector<float> floats;
+  std::vector<int64_t> longs;
+  std::vector<int16_t> shorts;
+  for (int i = 0; i < 1000; i++) {
+    floats.push_back(i * 0.5f);
+    longs.push_back(static_cast<int64_t>(i) << 40);
+    shorts.push_back(static_cast<int16_t>(-i));
+  }
+  CheckScalarVector(floats);
+  CheckScalarVector(longs);
+  CheckScalarVector(shorts);
+  CheckScalarVector(std::vector<double>());
+  std::vector<Color> colors = { Color_Red, Color_Blue, Color_Green };
+  CheckScalarVector(colors);
+}
+
+// Builds the same buffer with a regular and a segmented builder, and checks
+// they end up identical.
+void SegmentedBufferTest() {
+  auto build = [](flatbuffers::FlatBufferBuilder &builder) {
+    std::vector<flatbuffers::Offset<Monster>> monsters;
+    for (int i = 0; i < 2000; i++) {
+      auto name = builder.CreateSharedString("monster" +
+                                             flatbuffers::NumToString(i % 50));
+      std::vector<uint8_t> inventory(i % 100, static_cast<uint8_t>(i));
+      auto inv = builder.CreateVector(inventory);
+      Test tests[] = { Test(static_cast<int16_t>(i), 1), Test(2, 3) };
+      auto testv = builder.CreateVectorOfStructs(tests, 2);
+      monsters.push_back(CreateMonster(builder, nullptr, 150,
+                                       static_cast<int16_t>(i), name, inv,
+                                       Color_Blue, Any_NONE, 0, testv));
+    }
+    auto tables = builder.CreateVectorOfSortedTables(&monsters);
+    std::vector<flatbuffers::Offset<flatbuffers::String>> strings;
+    for (int i = 0; i < 2000; i++)
+      strings.push_back(builder.CreateString(std::string(i % 64, 'x')));
+    auto vecofstrings = builder.CreateVector(strings);
+    auto name = builder.CreateString("root");
+    auto root = CreateMonster(builder, nullptr, 150, 80, name, 0, Color_Blue,
+                              Any_NONE, 0, 0, vecofstrings, tables);
+    FinishMonsterBuffer(builder, root);
+  };
+
+  flatbuffers::FlatBufferBuilder regular;
+  build(regular);
+  TEST_EQ(regular.GetNumSegments(), 1U);
+
+  flatbuffers::FlatBufferBuilder segmented(64);
+  segmented.SetSegmented(true);
+  for (int iteration = 0; iteration < 2; iteration++) {
+    segmented.Clear();
+    build(segmented);
+    TEST_EQ(segmented.GetSize(), regular.GetSize());
+    // Clear() keeps the joined block from the first iteration, which is
+    // large enough to hold everything the second time around.
+    TEST_EQ(segmented.GetNumSegments() > 1, iteration == 0);
+    // The segments, concatenated, form the buffer.
+    std::string joined;
+    for (size_t i = 0; i < segmented.GetNumSegments(); i++) {
+      size_t len;
+      auto seg = segmented.GetSegment(i, &len);
+      joined.append(reinterpret_cast<const char *>(seg), len);
+    }
+    TEST_EQ(joined.size(), regular.GetSize());
+    TEST_EQ(memcmp(joined.data(), regular.GetBufferPointer(), joined.size()),
+            0);
+    // Getting a pointer joins the segments.
+    TEST_EQ(memcmp(segmented.GetBufferPointer(), regular.GetBufferPointer(),
+                   regular.GetSize()), 0);
+    TEST_EQ(segmented.GetNumSegments(), 1U);
+    flatbuffers::Verifier verifier(segmented.GetBufferPointer(),
+                                   segmented.GetSize());
+    TEST_EQ(VerifyMonsterBuffer(verifier), true);
+    auto monster = GetMonster(segmented.GetBufferPointer());
+    TEST_EQ(monster->testarrayoftables()->size(), 2000U);
+    TEST_NOTNULL(monster->testarrayoftables()->LookupByKey("monster42"));
+  }
+
+  // Popping bytes across segment boundaries.
+  flatbuffers::FlatBufferBuilder builder(64);
+  builder.SetSegmented(true);
+  builder.PushElement<uint32_t>(0xDEADBEEF);
+  auto size = builder.GetSize();
+  for (int i = 0; i < 1000; i++) builder.PushElement<uint32_t>(i);
+  TEST_EQ(builder.GetNumSegments() > 1, true);
+  builder.PopBytes(builder.GetSize() - size);
+  TEST_EQ(builder.GetSize(), size);
+  TEST_EQ(builder.GetNumSegments(), 1U);
+  TEST_EQ(flatbuffers::ReadScalar<uint32_t>(
+            builder.GetCurrentBufferPointer()), 0xDEADBEEF);
+}
+
+#if !defined(_WIN32) && !defined(FLATBUFFERS_NO_FILE_TESTS)
+// Writes a segmented buffer to a socket and a file with writev.
+void WriteIOVecsTest() {
+  flatbuffers::FlatBufferBuilder builder(64);
+  builder.SetSegmented(true);
+  std::vector<flatbuffers::Offset<flatbuffers::String>> strings;
+  for (int i = 0; i < 500; i++)
+    strings.push_back(builder.CreateString("string" +
+                                           flatbuffers::NumToString(i)));
+  builder.Finish(builder.CreateVector(strings));
+  TEST_EQ(builder.GetNumSegments() > 1, true);
+  std::vector<iovec> iov;
+  flatbuffers::GetBufferIOVecs(builder, &iov);
+  TEST_EQ(iov.size(), builder.GetNumSegments());
+
+  auto read_all = [](int fd, std::string *buf) {
+    char chunk[4096];
+    ssize_t len;
+    while ((len = read(fd, chunk, sizeof(chunk))) > 0) buf->append(chunk, len);
+    return len == 0;
+  };
+
+  int sockets[2];
+  TEST_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+  TEST_EQ(flatbuffers::WriteBuffer(sockets[0], builder), true);
+  close(sockets[0]);
+  std::string received;
+  TEST_EQ(read_all(sockets[1], &received), true);
+  close(sockets[1]);
+
+  auto file = tmpfile();
+  TEST_NOTNULL(file);
+  TEST_EQ(flatbuffers::WriteBuffer(fileno(file), builder), true);
+  TEST_EQ(lseek(fileno(file), 0, SEEK_SET), 0);
+  std::string stored;
+  TEST_EQ(read_all(fileno(file), &stored), true);
+  fclose(file);
+
+  // Only now join the segments, to compare against.
+  std::string expected(reinterpret_cast<char *>(builder.GetBufferPointer()),
+                       builder.GetSize());
+  TEST_EQ(received == expected, true);
+  TEST_EQ(stored == expected, true);
+}
+#endif
+
+// Counts the allocations made through it.
+class CountingAllocator : public flatbuffers::simple_allocator {
+ public:
+  CountingAllocator() : allocations(0), deallocations(0) {}
+  uint8_t *allocate(size_t size) const {
+    allocations++;
+    return simple_allocator::allocate(size);
+  }
+  void deallocate(uint8_t *p) const {
+    deallocations++;
+    simple_allocator::deallocate(p);
+  }
+  mutable std::atomic<size_t> allocations;
+  mutable std::atomic<size_t> deallocations;
+};
+
+void BuilderPoolTest() {
+  CountingAllocator allocator;
+  {
+    flatbuffers::BuilderPool pool(1024, 0, 16, &allocator);
+    const int num_threads = 4;
+    const int messages_per_thread = 500;
+    // TEST_EQ isn't thread-safe, so threads count the messages that came
+    // out right, to be checked once they're done.
+    std::vector<int> num_ok(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.push_back(std::thread([&pool, &num_ok, t]() {
+        for (int i = 0; i < messages_per_thread; i++) {
+          flatbuffers::BuilderPool::Lease fbb(pool);
+          auto was_empty = fbb->GetSize() == 0;
+          std::vector<uint8_t> inventory(i, static_cast<uint8_t>(t));
+          auto inv = fbb->CreateVector(inventory);
+          auto name = fbb->CreateString("pooled");
+          FinishMonsterBuffer(*fbb, CreateMonster(*fbb, nullptr, 150,
+                                                  static_cast<int16_t>(i),
+                                                  name, inv));
+          flatbuffers::Verifier verifier(fbb->GetBufferPointer(),
+                                         fbb->GetSize());
+          if (was_empty && VerifyMonsterBuffer(verifier) &&
+              GetMonster(fbb->GetBufferPointer())->hp() == i)
+            num_ok[t]++;
+        }
+      }));
+    }
+    for (auto it = threads.begin(); it != threads.end(); ++it) it->join();
+    for (int t = 0; t < num_threads; t++)
+      TEST_EQ(num_ok[t], messages_per_thread);
+    TEST_EQ(pool.NumAcquired(),
+            static_cast<size_t>(num_threads * messages_per_thread));
+    // Builders are only created when none is idle in a thread's shard, and
+    // they only allocate while growing to the largest message size.
+    TEST_EQ(pool.NumCreated() <= static_cast<size_t>(num_threads), true);
+    TEST_EQ(allocator.allocations <= pool.NumCreated() * 4, true);
+  }
+
+  // Oversized builders are dropped rather than kept.
+  flatbuffers::BuilderPool pool(1024, 4096);
+  auto fbb = pool.Acquire();
+  pool.Release(fbb);
+  fbb = pool.Acquire();
+  TEST_EQ(pool.NumCreated(), 1U);
+  std::vector<uint8_t> big(10000);
+  fbb->Finish(fbb->CreateVector(big));
+  pool.Release(fbb);
+  fbb = pool.Acquire();
+  TEST_EQ(pool.NumCreated(), 2U);
+  TEST_EQ(fbb->GetCapacity(), 1024U);
+  pool.Release(fbb);
+
+  // Settings made by one lessee don't carry over to the next.
+  flatbuffers::BuilderPool settings_pool(64);
+  {
+    flatbuffers::BuilderPool::Lease lease(settings_pool);
+    // Goes out of scope before the lease is released.
+    flatbuffers::BufferSizeStats size_stats;
+    lease->ForceDefaults(true);
+    lease->SetSegmented(true);
+    lease->SetSharedStringLimit(0);
+    lease->SetSizeStats(&size_stats);
+  }
+  flatbuffers::BuilderPool::Lease lease(settings_pool);
+  TEST_EQ(settings_pool.NumCreated(), 1U);
+  flatbuffers::FlatBufferBuilder fresh(64);
+  lease->Finish(CreateStat(*lease, 0, 0, 0));
+  fresh.Finish(CreateStat(fresh, 0, 0, 0));
+  TEST_EQ(lease->GetSize(), fresh.GetSize());  // No defaults stored.
+  lease->Clear();
+  TEST_EQ(lease->CreateSharedString("shared").o,
+          lease->CreateSharedString("shared").o);
+  lease->Finish(lease->CreateVector(big));
+  TEST_EQ(lease->GetNumSegments(), 1U);
+}
+
+void ArenaAllocatorTest() {
+  flatbuffers::arena_allocator arena;
+  size_t blocks_used = 0;
+  for (int batch = 0; batch < 2; batch++) {
+    std::vector<flatbuffers::unique_ptr_t> buffers;
+    for (int i = 0; i < 1000; i++) {
+      flatbuffers::FlatBufferBuilder fbb(256, &arena);
+      std::vector<uint8_t> inventory(i % 300);
+      auto inv = fbb.CreateVector(inventory);
+      auto name = fbb.CreateString("arena");
+      FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150,
+                                             static_cast<int16_t>(i), name,
+                                             inv));
+      // Released buffers outlive their builder, but not the arena.
+      buffers.push_back(fbb.ReleaseBufferPointer());
+    }
+    for (int i = 0; i < 1000; i++) {
+      auto monster = GetMonster(buffers[i].get());
+      TEST_EQ(monster->hp(), i);
+      TEST_EQ(VectorLength(monster->inventory()),
+              static_cast<size_t>(i % 300));
+    }
+    buffers.clear();
+    // The second batch reuses the blocks of the first.
+    if (batch) TEST_EQ(arena.num_blocks(), blocks_used);
+    blocks_used = arena.num_blocks();
+    arena.reset();
+  }
+
+  // Released buffers are deallocated through the builder's allocator.
+  CountingAllocator allocator;
+  flatbuffers::unique_ptr_t buf;
+  {
+    flatbuffers::FlatBufferBuilder fbb(1024, &allocator);
+    fbb.Finish(fbb.CreateString("released"));
+    buf = fbb.ReleaseBufferPointer();
+  }
+  TEST_EQ(allocator.deallocations.load(), 0U);
+  buf.reset();
+  TEST_EQ(allocator.deallocations.load(), 1U);
+  TEST_EQ(allocator.allocations.load(), 1U);
+}
+
+void SizeStatsTest() {
+  // An explicit size hint.
+  flatbuffers::FlatBufferBuilder hinted;
+  hinted.Reserve(100000);
+  std::vector<uint8_t> big(90000);
+  hinted.Finish(hinted.CreateVector(big));
+  TEST_EQ(hinted.GetNumReallocations(), 0U);
+
+  // Learning the size from earlier buffers, with a builder per buffer.
+  flatbuffers::BufferSizeStats stats;
+  size_t reallocations_after_warmup = 0;
+  for (int i = 0; i < 50; i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    fbb.SetSizeStats(&stats);
+    std::vector<uint8_t> inventory(40000 + (i % 10) * 1000);
+    auto inv = fbb.CreateVector(inventory);
+    FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150, 80,
+                                           fbb.CreateString("stats"), inv));
+    if (!i) TEST_EQ(stats.Reallocations() > 0, true);
+    if (i == 9) reallocations_after_warmup = stats.Reallocations();
+  }
+  // Once all sizes have been seen, nothing reallocates anymore.
+  TEST_EQ(stats.Reallocations(), reallocations_after_warmup);
+  TEST_EQ(stats.ReallocationsAvoided() >= 40, true);
+  TEST_EQ(stats.Estimate() >= 49000, true);
+
+  // Reusing a builder reserves on Clear().
+  flatbuffers::BufferSizeStats reuse_stats;
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.SetSizeStats(&reuse_stats);
+  fbb.Finish(fbb.CreateVector(big));
+  fbb.ReleaseBufferPointer();
+  fbb.Clear();
+  auto reallocations = fbb.GetNumReallocations();
+  fbb.Finish(fbb.CreateVector(big));
+  TEST_EQ(fbb.GetNumReallocations(), reallocations);
+}
+
+void TableBatchTest() {
+  flatbuffers::FlatBufferBuilder fbb;
+  const int num_tables = 1000;
+  auto tables = fbb.CreateVectorOfTables<Monster>(num_tables,
+    [&](size_t i) {
+      auto name = fbb.CreateString("row" + flatbuffers::NumToString(i));
+      // Every 100th row has the default hp.
+      return CreateMonster(fbb, nullptr, 150,
+                           static_cast<int16_t>(i % 100 ? i : 100), name);
+    });
+  auto root = CreateMonster(fbb, nullptr, 150, 80, fbb.CreateString("root"),
+                            0, Color_Blue, Any_NONE, 0, 0, 0, tables);
+  FinishMonsterBuffer(fbb, root);
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  auto rows = GetMonster(fbb.GetBufferPointer())->testarrayoftables();
+  TEST_EQ(rows->size(), static_cast<flatbuffers::uoffset_t>(num_tables));
+  auto vtable_of = [](const Monster *row) {
+    return reinterpret_cast<const uint8_t *>(row) -
+           flatbuffers::ReadScalar<flatbuffers::soffset_t>(row);
+  };
+  std::set<const uint8_t *> vtables;
+  for (int i = 0; i < num_tables; i++) {
+    auto row = rows->Get(i);
+    TEST_EQ(row->hp(), i % 100 ? i : 100);
+    TEST_EQ_STR(row->name()->c_str(),
+                ("row" + flatbuffers::NumToString(i)).c_str());
+    vtables.insert(vtable_of(row));
+  }
+  // All rows share a layout (since defaults were stored too), apart from the
+  // padding needed to align their 8-byte fields.
+  TEST_EQ(vtables.size() <= 2, true);
+
+  // Vectors of offsets are written in bulk; check that gives the same bytes
+  // as pushing the elements one by one.
+  flatbuffers::FlatBufferBuilder bulk, single;
+  std::vector<flatbuffers::Offset<flatbuffers::String>> bulk_strings,
+                                                        single_strings;
+  for (int i = 0; i < 100; i++) {
+    auto str = flatbuffers::NumToString(i);
+    bulk_strings.push_back(bulk.CreateString(str));
+    single_strings.push_back(single.CreateString(str));
+  }
+  auto bulk_vec = bulk.CreateVector(bulk_strings);
+  single.StartVector(single_strings.size(), sizeof(flatbuffers::uoffset_t));
+  for (auto i = single_strings.size(); i > 0; )
+    single.PushElement(single_strings[--i]);
+  auto single_vec = single.EndVector(single_strings.size());
+  TEST_EQ(bulk_vec.o, single_vec);
+  TEST_EQ(bulk.GetSize(), single.GetSize());
+  TEST_EQ(memcmp(bulk.GetCurrentBufferPointer(),
+                 single.GetCurrentBufferPointer(), bulk.GetSize()), 0);
+}
+
+// Builds rows on multiple threads, each in their own builder, and splices
+// them into one buffer.
+void SpliceTest() {
+  const int num_threads = 4;
+  const int rows_per_thread = 250;
+  const int num_rows = num_threads * rows_per_thread;
+  std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> children;
+  for (int i = 0; i < num_rows; i++) {
+    children.push_back(std::unique_ptr<flatbuffers::FlatBufferBuilder>(
+      new flatbuffers::FlatBufferBuilder(64)));
+    // Splicing works from segmented builders too.
+    children.back()->SetSegmented(i % 2 != 0);
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.push_back(std::thread([&children, t]() {
+      for (int i = t * rows_per_thread; i < (t + 1) * rows_per_thread; i++) {
+        auto &fbb = *children[i];
+        std::vector<uint8_t> inventory(i % 200, static_cast<uint8_t>(i));
+        auto inv = fbb.CreateVector(inventory);
+        auto name = fbb.CreateString("row" + flatbuffers::NumToString(i));
+        // Includes 8-byte fields, to check their alignment is preserved.
+        FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150,
+                                               static_cast<int16_t>(i), name,
+                                               inv, Color_Blue, Any_NONE, 0, 0,
+                                               0, 0, 0, 0, 0, false, 0, 0,
+                                               i * 1000000000LL));
+      }
+    }));
+  }
+  for (auto it = threads.begin(); it != threads.end(); ++it) it->join();
+
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.CreateString("unaligned");
+  std::vector<flatbuffers::Offset<Monster>> rows;
+  for (int i = 0; i < num_rows; i++)
+    rows.push_back(fbb.Splice<Monster>(*children[i]));
+  // Also splice a buffer from raw bytes.
+  auto raw = children[0]->GetBufferPointer();
+  rows.push_back(fbb.Splice<Monster>(raw, children[0]->GetSize()));
+  auto tables = fbb.CreateVector(rows);
+  FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150, 80,
+                                         fbb.CreateString("root"), 0,
+                                         Color_Blue, Any_NONE, 0, 0, 0,
+                                         tables));
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  auto spliced = GetMonster(fbb.GetBufferPointer())->testarrayoftables();
+  TEST_EQ(spliced->size(), static_cast<flatbuffers::uoffset_t>(num_rows + 1));
+  for (int i = 0; i <= num_rows; i++) {
+    auto row = spliced->Get(i);
+    auto j = i % num_rows;
+    TEST_EQ(row->hp(), j);
+    TEST_EQ_STR(row->name()->c_str(),
+                ("row" + flatbuffers::NumToString(j)).c_str());
+    TEST_EQ(VectorLength(row->inventory()), static_cast<size_t>(j % 200));
+    TEST_EQ(row->testhashs64_fnv1(), j * 1000000000LL);
+    TEST_EQ(reinterpret_cast<uintptr_t>(row) % 4, 0U);
+  }
+}
+
+void BatchVerifierTest() {
+  const size_t num_buffers = 1000;
+  std::vector<std::string> buffers;
+  for (size_t i = 0; i < num_buffers; i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<Monster>> children;
+    for (size_t j = 0; j < i % 5; j++)
+      children.push_back(CreateMonster(fbb, nullptr, 150, 80,
+                                       fbb.CreateString("child")));
+    auto tables = fbb.CreateVector(children);
+    FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150,
+                                           static_cast<int16_t>(i),
+                                           fbb.CreateString("batch"), 0,
+                                           Color_Blue, Any_NONE, 0, 0, 0,
+                                           tables));
+    buffers.push_back(std::string(
+      reinterpret_cast<const char *>(fbb.GetBufferPointer()), fbb.GetSize()));
+  }
+  std::vector<flatbuffers::BufferRef> refs;
+  for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+    flatbuffers::BufferRef ref = {
+      reinterpret_cast<const uint8_t *>(it->data()), it->size()
+    };
+    refs.push_back(ref);
+  }
+
+  // Buffers that fail verification (which would assert in these tests, see
+  // FLATBUFFERS_DEBUG_VERIFICATION_FAILURE) are simulated by rejecting
+  // buffers whose hp (= index) is a multiple of 7, or all of one chunk.
+  auto rejected = [](size_t i) { return i % 7 == 0 || (i >= 128 && i < 192); };
+  auto verify = [&](flatbuffers::Verifier &verifier) {
+    return VerifyMonsterBuffer(verifier) &&
+           !rejected(static_cast<size_t>(
+              verifier.GetRootChecked<Monster>()->hp()));
+  };
+  std::vector<uint64_t> results;
+  auto check = [&]() {
+    TEST_EQ(results.size(), (num_buffers + 63) / 64);
+    for (size_t i = 0; i < num_buffers; i++)
+      TEST_EQ(flatbuffers::BufferVerified(results, i), !rejected(i));
+    // Bits past the last buffer stay clear.
+    TEST_EQ(results.back() >> (num_buffers % 64), 0U);
+  };
+  for (size_t threads = 1; threads <= 8; threads *= 2) {
+    flatbuffers::VerifyBuffers(refs.data(), refs.size(), verify, &results,
+                               threads);
+    check();
+  }
+  // A pool can be reused for many batches.
+  flatbuffers::WorkerPool pool(4);
+  for (int batch = 0; batch < 3; batch++) {
+    results.assign(results.size(), ~static_cast<uint64_t>(0));
+    flatbuffers::VerifyBuffers(refs.data(), refs.size(), verify, &results,
+                               pool);
+    check();
+  }
+  flatbuffers::VerifyBuffers(refs.data(), 0, verify, &results, pool);
+  TEST_EQ(results.empty(), true);
+  // The table limit applies to each buffer separately (each has at most 5
+  // tables, but thousands in total).
+  flatbuffers::VerifyBuffers<Monster>(refs.data(), refs.size(), &results, 4,
+                                      64, 5);
+  for (size_t i = 0; i < num_buffers; i++)
+    TEST_EQ(flatbuffers::BufferVerified(results, i), true);
+}
+
+// Read a few fields of a buffer that hasn't been verified, checking just
+// those (see --gen-bounds-checked). What gets checked, and corrupt buffers,
+// are tested in verifier_stats_test.cpp.
+void BoundsCheckedAccessTest(const uint8_t *flatbuf, size_t length) {
+  flatbuffers::Verifier verifier(flatbuf, length);
+  auto monster = GetMonsterChecked(verifier);
+  TEST_NOTNULL(monster);
+  TEST_EQ(monster->hp(verifier), 80);
+  TEST_EQ(monster->mana(verifier), 150);  // default
+  TEST_EQ_STR(monster->name(verifier)->c_str(), "MyMonster");
+  TEST_EQ(monster->pos(verifier)->z(), 3);
+  TEST_EQ(monster->inventory(verifier)->Get(9), 9);
+  TEST_EQ(monster->color(verifier), Color_Blue);
+  TEST_EQ(monster->test_type(verifier), Any_Monster);
+  auto monster2 = reinterpret_cast<const Monster *>(monster->test(verifier));
+  TEST_EQ_STR(monster2->name(verifier)->c_str(), "Fred");
+  TEST_EQ(monster->test4(verifier)->Get(1)->b(), 40);
+  TEST_EQ_STR(monster->testarrayofstring(verifier)->Get(1)->c_str(), "fred");
+  auto vecoftables = monster->testarrayoftables(verifier);
+  TEST_EQ_STR(vecoftables->Get(2)->name(verifier)->c_str(), "Wilma");
+  // Absent fields read as usual.
+  TEST_EQ(monster->enemy(verifier) == nullptr, true);
+  TEST_EQ(monster->testnestedflatbuffer(verifier) == nullptr, true);
+}
+
+void LookupByKeyTest() {
+  // All sizes up to a few levels of search, looking up every key, as well
+  // as keys before, between and after them, with and without a hash index.
+  for (int size = 0; size < 40; size++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<KeyTest::Entry>> entries;
+    for (int i = 0; i < size; i++) {
+      char name[16];
+      sprintf(name, "m%03d", i * 2 + 1);
+      entries.push_back(KeyTest::CreateEntry(fbb, fbb.CreateString(name)));
+    }
+    auto vec = fbb.CreateVectorOfSortedTables(&entries);
+    auto index = fbb.CreateHashIndex(entries);
+    fbb.Finish(KeyTest::CreateEntries(fbb, vec, index));
+    auto root = flatbuffers::GetRoot<KeyTest::Entries>(fbb.GetBufferPointer());
+    auto tables = root->entries();
+    TEST_EQ(root->entries_index()->size() >= 2U * size, true);
+    for (int k = 0; k <= size * 2; k++) {
+      char name[16];
+      sprintf(name, "m%03d", k);
+      // Binary search, then using the hash index.
+      const KeyTest::Entry *found[] = {
+        tables->LookupByKey(static_cast<const char *>(name)),
+        root->entries_by_key(name)
+      };
+      for (int i = 0; i < 2; i++) {
+        if (k & 1) {
+          TEST_NOTNULL(found[i]);
+          TEST_EQ_STR(found[i]->name()->c_str(), name);
+        } else {
+          TEST_EQ(found[i] == nullptr, true);
+        }
+      }
+    }
+  }
+}
+
+void FloatKeyTest() {
+  TEST_EQ(flatbuffers::HashKey(-0.0), flatbuffers::HashKey(0.0));
+  TEST_EQ(flatbuffers::HashKey(-0.0f), flatbuffers::HashKey(0.0f));
+  TEST_EQ(flatbuffers::HashKey(std::numeric_limits<double>::quiet_NaN()),
+          flatbuffers::HashKey(-std::numeric_limits<double>::quiet_NaN()));
+  TEST_EQ(flatbuffers::HashKey(1.0) != flatbuffers::HashKey(-1.0), true);
+
+  // Zero stored as 0.0 and as -0.0, looked up as either.
+  for (int negative = 0; negative < 2; negative++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    fbb.ForceDefaults(true);
+    double values[] = { -2.5, negative ? -0.0 : 0.0, 1.0, 3.5, 1e300 };
+    std::vector<flatbuffers::Offset<KeyTest::Reading>> readings;
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+      readings.push_back(KeyTest::CreateReading(fbb, values[i]));
+    auto vec = fbb.CreateVectorOfSortedTables(&readings);
+    auto index = fbb.CreateHashIndex(readings);
+    fbb.Finish(KeyTest::CreateReadings(fbb, vec, index));
+    auto root = KeyTest::GetReadings(fbb.GetBufferPointer());
+    for (int zero = 0; zero < 2; zero++) {
+      auto key = zero ? -0.0 : 0.0;
+      auto found = root->readings_by_key(key);
+      TEST_NOTNULL(found);
+      TEST_EQ(found, root->readings()->LookupByKey(key));
+      TEST_EQ(std::signbit(found->value()), negative != 0);
+    }
+    TEST_EQ(root->readings_by_key(3.5)->value(), 3.5);
+    TEST_EQ(root->readings_by_key(2.0) == nullptr, true);
+    // NaN equals nothing, so is never found.
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    TEST_EQ(root->readings_by_key(nan) == nullptr, true);
+    TEST_EQ(root->readings()->LookupByKey(nan) == nullptr, true);
+  }
+}
+
+void KeyIndexTest() {
+  // Prefixes sort like their keys.
+  TEST_EQ(flatbuffers::KeyPrefix("ab") < flatbuffers::KeyPrefix("ab\x01"),
+          true);
+  TEST_EQ(flatbuffers::KeyPrefix("ab\xff") < flatbuffers::KeyPrefix("b"),
+          true);
+  TEST_EQ(flatbuffers::KeyPrefix("abcdefgh1"),
+          flatbuffers::KeyPrefix("abcdefgh2"));
+  TEST_EQ(flatbuffers::KeyPrefix(-2) < flatbuffers::KeyPrefix(-1), true);
+  TEST_EQ(flatbuffers::KeyPrefix(-1) < flatbuffers::KeyPrefix(0), true);
+  TEST_EQ(flatbuffers::KeyPrefix(-1.5f) < flatbuffers::KeyPrefix(-1.0f), true);
+  TEST_EQ(flatbuffers::KeyPrefix(-0.0), flatbuffers::KeyPrefix(0.0));
+  TEST_EQ(flatbuffers::KeyPrefix(0.0) < flatbuffers::KeyPrefix(1e-300), true);
+
+  // Lookups of all sizes, with duplicate keys, and keys in between.
+  for (int size = 0; size < 70; size++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<KeyTest::Counter>> counters;
+    for (int i = 0; i < size; i++) {
+      counters.push_back(KeyTest::CreateCounter(
+                           fbb, static_cast<uint16_t>(i / 2 * 3)));
+    }
+    auto vec = fbb.CreateVectorOfSortedTables(&counters);
+    auto index = fbb.CreateKeyIndex(counters);
+    fbb.Finish(KeyTest::CreateCounters(fbb, vec, index));
+    auto root = flatbuffers::GetRoot<KeyTest::Counters>(
+                  fbb.GetBufferPointer());
+    auto tables = root->counters();
+    TEST_EQ(root->counters_index()->size(), flatbuffers::KeyIndexSize(size));
+    for (int k = 0; k < size / 2 * 3 + 3; k++) {
+      auto key = static_cast<uint16_t>(k);
+      auto found = root->counters_by_key(key);
+      if (k % 3 == 0 && k / 3 * 2 < size) {
+        TEST_NOTNULL(found);
+        TEST_EQ(found->count(), k);
+      } else {
+        TEST_EQ(found == nullptr, true);
+      }
+      // The first of any duplicates, or where the key would go.
+      auto lower = (std::min)((k + 2) / 3 * 2, size);
+      TEST_EQ(root->counters_lower_bound(key),
+              static_cast<flatbuffers::uoffset_t>(lower));
+      TEST_EQ(tables->LowerBoundByKey(key),
+              static_cast<flatbuffers::uoffset_t>(lower));
+    }
+    // Iterate over a range of keys [3, 9).
+    int num_in_range = 0;
+    for (auto i = root->counters_lower_bound(3);
+         i < root->counters_lower_bound(9); i++) {
+      TEST_EQ(tables->Get(i)->count() >= 3 && tables->Get(i)->count() < 9,
+              true);
+      num_in_range++;
+    }
+    TEST_EQ(num_in_range, (std::max)(0, (std::min)(size, 6) - 2));
+  }
+}
+
+void ForEachPrefetchedTest(const uint8_t *flatbuf) {
+  auto monster = GetMonster(flatbuf);
+  for (flatbuffers::uoffset_t distance = 0; distance < 6; distance++) {
+    std::string names;
+    flatbuffers::ForEachPrefetched(*monster->testarrayoftables(),
+                                   [&](const Monster *m) {
+                                     names += m->name()->str();
+                                   }, distance);
+    flatbuffers::ForEachPrefetched(*monster->testarrayofstring(),
+                                   [&](const flatbuffers::String *str) {
+                                     names += str->str();
+                                   }, distance);
+    TEST_EQ_STR(names.c_str(), "BarneyFredWilmabobfred");
+  }
+}
+
+void GatherFieldTest() {
+  // Tables with a few different vtables, some without the field.
+  flatbuffers::FlatBufferBuilder fbb;
+  std::vector<flatbuffers::Offset<Monster>> monsters;
+  for (int i = 0; i < 100; i++) {
+    auto name = fbb.CreateString("m");
+    MonsterBuilder mb(fbb);
+    mb.add_name(name);
+    if (i % 3) mb.add_hp(static_cast<int16_t>(i));
+    if (i % 5 == 0) mb.add_mana(0);
+    monsters.push_back(mb.Finish());
+  }
+  auto vec = fbb.CreateVector(monsters);
+  FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150, 80,
+                                         fbb.CreateString("root"), 0,
+                                         Color_Blue, Any_NONE, 0, 0, 0, vec));
+  auto tables = GetMonster(fbb.GetBufferPointer())->testarrayoftables();
+  std::vector<int16_t> hps(tables->size());
+  flatbuffers::GatherField(*tables, Monster::VT_HP, static_cast<int16_t>(100),
+                           hps.data());
+  for (flatbuffers::uoffset_t i = 0; i < tables->size(); i++)
+    TEST_EQ(hps[i], tables->Get(i)->hp());
+}
+
+void MappedFileTest() {
+  flatbuffers::MappedFile mapped;
+  TEST_EQ(mapped.Open("tests/does_not_exist.mon"), false);
+  TEST_EQ(mapped.Open("tests/monsterdata_test.mon"), true);
+  std::string loaded;
+  TEST_EQ(flatbuffers::LoadFile("tests/monsterdata_test.mon", true, &loaded),
+          true);
+  TEST_EQ(mapped.size(), loaded.size());
+  TEST_EQ(memcmp(mapped.data(), loaded.data(), loaded.size()), 0);
+  #ifndef _WIN32
+  TEST_EQ(mapped.Advise(flatbuffers::MappedFile::kRandom), true);
+  #endif
+  flatbuffers::Verifier verifier(mapped.data(), mapped.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ_STR(mapped.GetRoot<Monster>()->name()->c_str(), "MyMonster");
+
+  // Copy-on-write mappings can be mutated without changing the file.
+  flatbuffers::MappedFile copy;
+  TEST_EQ(copy.Open("tests/monsterdata_test.mon",
+                    flatbuffers::MappedFile::kCopyOnWrite), true);
+  auto monster = copy.GetMutableRoot<Monster>();
+  TEST_EQ(monster->mutate_hp(monster->hp() + 1), true);
+  TEST_EQ(memcmp(mapped.data(), loaded.data(), loaded.size()), 0);
+  TEST_EQ(copy.GetRoot<Monster>()->hp(),
+          mapped.GetRoot<Monster>()->hp() + 1);
+  copy.Close();
+  TEST_EQ(copy.data() == nullptr, true);
+
+  // Empty files can't be mapped, but still open, with nothing in them.
+  const char *empty_path = "tests/mapped_file_empty.tmp";
+  TEST_EQ(flatbuffers::SaveFile(empty_path, "", 0, true), true);
+  TEST_EQ(mapped.Open(empty_path), true);
+  TEST_EQ(mapped.data() == nullptr, true);
+  TEST_EQ(mapped.size(), 0U);
+  TEST_EQ(mapped.Advise(flatbuffers::MappedFile::kRandom), false);
+  remove(empty_path);
+}
+
+void FrameReaderTest() {
+  // Frames of various sizes and alignments, one after the other.
+  std::string frames;
+  const int kNumFrames = 50;
+  for (int i = 0; i < kNumFrames; i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<uint8_t> inventory(i * 7, 1);
+    auto inv = fbb.CreateVector(inventory);
+    auto name = fbb.CreateString(flatbuffers::NumToString(i));
+    auto monster = CreateMonster(fbb, nullptr, 150, static_cast<int16_t>(i),
+                                 name, inv);
+    if (i % 3) {
+      fbb.FinishSizePrefixed(monster, MonsterIdentifier());
+    } else {
+      // Includes a double, so the buffer is 8 byte aligned.
+      Vec3 vec(1, 2, 3, 0, Color_Red, Test(10, 20));
+      fbb.FinishSizePrefixed(CreateMonster(fbb, &vec, 150,
+                                           static_cast<int16_t>(i), name,
+                                           inv),
+                             MonsterIdentifier());
+    }
+    TEST_EQ(flatbuffers::GetPrefixedSize(fbb.GetBufferPointer()),
+            fbb.GetSize() - sizeof(flatbuffers::uoffset_t));
+    TEST_EQ(flatbuffers::GetSizePrefixedRoot<Monster>(
+              fbb.GetBufferPointer())->hp(), i);
+    frames.append(reinterpret_cast<const char *>(fbb.GetBufferPointer()),
+                  fbb.GetSize());
+  }
+  auto check_frames = [&](flatbuffers::FrameReader &reader) {
+    // Skip the odd ones.
+    reader.SetVerifier([](flatbuffers::Verifier &verifier) {
+      return VerifyMonsterBuffer(verifier) &&
+             verifier.GetRootChecked<Monster>()->hp() % 2 == 0;
+    });
+    size_t size;
+    int i = 0;
+    while (auto frame = reader.Next(&size)) {
+      TEST_EQ(reinterpret_cast<uintptr_t>(frame - sizeof(flatbuffers::uoffset_t))
+              % sizeof(flatbuffers::largest_scalar_t), 0U);
+      auto monster = GetMonster(frame);
+      TEST_EQ(monster->hp(), i);
+      TEST_EQ_STR(monster->name()->c_str(),
+                  flatbuffers::NumToString(i).c_str());
+      TEST_EQ(monster->inventory()->size(), i * 7U);
+      i += 2;
+    }
+    TEST_EQ(i, kNumFrames);
+    TEST_EQ(reader.NumFrames(), kNumFrames / 2U);
+    TEST_EQ(reader.NumSkipped(), kNumFrames / 2U);
+  };
+
+  // From memory, starting at an odd address, and truncated.
+  std::string unaligned = "x" + frames + "abc";
+  flatbuffers::FrameReader reader(
+    reinterpret_cast<const uint8_t *>(unaligned.data()) + 1,
+    unaligned.size() - 1);
+  check_frames(reader);
+  TEST_EQ(reader.Error(), true);
+
+  #ifndef _WIN32
+  // From a pipe, with a buffer smaller than most frames.
+  int fds[2];
+  TEST_EQ(pipe(fds), 0);
+  TEST_EQ(write(fds[1], frames.data(), frames.size()),
+          static_cast<ssize_t>(frames.size()));
+  close(fds[1]);
+  flatbuffers::FrameReader fd_reader(fds[0], 64);
+  check_frames(fd_reader);
+  TEST_EQ(fd_reader.Error(), false);
+  close(fds[0]);
+  #endif
+}
+
 // High level stress/fuzz test: generate a big schema and
 // matching json data in random combinations, then parse both,
 // generate json back from the binary, and compare with the original.
@@ -758,6 +2227,10 @@ void ErrorTest() {
   TestError("table X { Y:[int]; YLength:int; }", "clash");
   TestError("table X { Y:string = 1; }", "scalar");
   TestError("table X { Y:byte; } root_type X; { Y:1, Y:2 }", "more than once");
+  TestError("table X { Y:[int] (hash_index: \"Z\"); }", "vector of uint");
+  TestError("table X { Y:[uint] (hash_index: \"Z\"); }", "vector of tables");
+  TestError("table X { Z:[X]; Y:[uint] (hash_index: \"Z\"); }",
+            "with a key");
 }
 
 // Additional parser testing not covered elsewhere.
@@ -815,11 +2288,40 @@ int main(int /*argc*/, const char * /*argv*/[]) {
   #ifndef FLATBUFFERS_NO_FILE_TESTS
   ParseAndGenerateTextTest();
   ReflectionTest(flatbuf.get(), rawbuf.length());
+  MutationTransactionTest(flatbuf.get(), rawbuf.length());
+  TableCopierTest(flatbuf.get());
+  SchemaIndexTest(flatbuf.get(), rawbuf.length());
+  FieldHandleTest(flatbuf.get(), rawbuf.length());
+  SchemaConverterTest();
   ParseProtoTest();
   #endif
 
   FuzzTest1();
   FuzzTest2();
+  VTableDedupTest();
+  SharedStringTest();
+  ScalarVectorTest();
+  SegmentedBufferTest();
+  #if !defined(_WIN32) && !defined(FLATBUFFERS_NO_FILE_TESTS)
+  WriteIOVecsTest();
+  #endif
+  BuilderPoolTest();
+  ArenaAllocatorTest();
+  SizeStatsTest();
+  TableBatchTest();
+  SpliceTest();
+  BatchVerifierTest();
+  BoundsCheckedAccessTest(reinterpret_cast<const uint8_t *>(rawbuf.c_str()),
+                          rawbuf.length());
+  LookupByKeyTest();
+  FloatKeyTest();
+  KeyIndexTest();
+  ForEachPrefetchedTest(flatbuf.get());
+  GatherFieldTest();
+  #ifndef FLATBUFFERS_NO_FILE_TESTS
+  MappedFileTest();
+  #endif
+  FrameReaderTest();
 
   ErrorTest();
   ScientificTest();
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the Verifier with FLATBUFFERS_VERIFIER_STATS, which changes its
+// layout, so can't be mixed with test.cpp in one program. Unlike test.cpp,
+// this doesn't define FLATBUFFERS_DEBUG_VERIFICATION_FAILURE, so it can
+// check how corrupt buffers fail.
+
+#define FLATBUFFERS_VERIFIER_STATS 1
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "monster_test_generated.h"
+#include "test_assert.h"
+
+using namespace MyGame::Example;
+
+int testing_fails = 0;
+
+// A root with 2 children in testarrayoftables, the first of which has an
+// enemy of its own.
+std::string CreateFamily() {
+  flatbuffers::FlatBufferBuilder fbb;
+  auto grandchild = CreateMonster(fbb, nullptr, 150, 80,
+                                  fbb.CreateString("grandchild"));
+  auto child1 = CreateMonster(fbb, nullptr, 150, 80,
+                              fbb.CreateString("child1"), 0, Color_Blue,
+                              Any_NONE, 0, 0, 0, 0, grandchild);
+  auto child2 = CreateMonster(fbb, nullptr, 150, 80,
+                              fbb.CreateString("child2"));
+  flatbuffers::Offset<Monster> children[] = { child1, child2 };
+  auto tables = fbb.CreateVector(children, 2);
+  FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 150, 80,
+                                         fbb.CreateString("root"), 0,
+                                         Color_Blue, Any_NONE, 0, 0, 0,
+                                         tables));
+  return std::string(reinterpret_cast<const char *>(fbb.GetBufferPointer()),
+                     fbb.GetSize());
+}
+
+// Where "p" is in "buf".
+ptrdiff_t OffsetOf(const std::string &buf, const void *p) {
+  return reinterpret_cast<const uint8_t *>(p) -
+         reinterpret_cast<const uint8_t *>(buf.data());
+}
+
+const flatbuffers::Verifier::Stats &Verify(flatbuffers::Verifier *verifier,
+                                           bool ok) {
+  TEST_EQ(VerifyMonsterBuffer(*verifier), ok);
+  return verifier->GetStats();
+}
+
+void VerifierStatsTest() {
+  auto buf = CreateFamily();
+  auto data = reinterpret_cast<const uint8_t *>(buf.data());
+  flatbuffers::Verifier verifier(data, buf.size());
+  auto &stats = Verify(&verifier, true);
+  TEST_EQ(stats.failure, flatbuffers::Verifier::kNoFailure);
+  TEST_EQ(verifier.GetNumTables(), 4U);
+  TEST_EQ(stats.max_depth, 3U);
+  TEST_EQ(stats.bytes_verified >= buf.size() / 2, true);
+  TEST_EQ(stats.failure_table, -1);
+}
+
+void BadVTableTest() {
+  auto buf = CreateFamily();
+  auto data = reinterpret_cast<uint8_t *>(&buf[0]);
+  auto root = OffsetOf(buf, GetMonster(data));
+  // Point the vtable of the root past the end of the buffer.
+  flatbuffers::WriteScalar(data + root,
+                           -static_cast<flatbuffers::soffset_t>(buf.size()));
+  flatbuffers::Verifier verifier(data, buf.size());
+  auto &stats = Verify(&verifier, false);
+  TEST_EQ(stats.failure, flatbuffers::Verifier::kOutOfBounds);
+  TEST_EQ(stats.failure_offset, root + static_cast<ptrdiff_t>(buf.size()));
+  TEST_EQ(stats.failure_table, root);
+  TEST_EQ(stats.failure_field, 0);
+}
+
+void StringPastEndTest() {
+  auto buf = CreateFamily();
+  auto data = reinterpret_cast<uint8_t *>(&buf[0]);
+  auto monster = GetMonster(data);
+  auto root = OffsetOf(buf, monster);
+  auto name = OffsetOf(buf, monster->name());
+  flatbuffers::WriteScalar(data + name,
+                           static_cast<flatbuffers::uoffset_t>(buf.size()));
+  flatbuffers::Verifier verifier(data, buf.size());
+  auto &stats = Verify(&verifier, false);
+  TEST_EQ(stats.failure, flatbuffers::Verifier::kOutOfBounds);
+  TEST_EQ(stats.failure_offset, name);
+  TEST_EQ(stats.failure_table, root);
+  TEST_EQ(stats.failure_field, Monster::VT_NAME);
+
+  // The same string, missing its terminator.
+  buf = CreateFamily();
+  data = reinterpret_cast<uint8_t *>(&buf[0]);
+  auto length = GetMonster(data)->name()->size();
+  auto end = name + static_cast<ptrdiff_t>(sizeof(flatbuffers::uoffset_t) +
+                                           length);
+  data[end] = 'x';
+  flatbuffers::Verifier verifier2(data, buf.size());
+  auto &stats2 = Verify(&verifier2, false);
+  TEST_EQ(stats2.failure, flatbuffers::Verifier::kStringNotTerminated);
+  TEST_EQ(stats2.failure_offset, end);
+  TEST_EQ(stats2.failure_table, root);
+  TEST_EQ(stats2.failure_field, Monster::VT_NAME);
+}
+
+void TooManyTablesTest() {
+  auto buf = CreateFamily();
+  auto data = reinterpret_cast<const uint8_t *>(buf.data());
+  // Tables are verified depth first: root, child1, its enemy, child2.
+  auto child2 = OffsetOf(buf, GetMonster(data)->testarrayoftables()->Get(1));
+  flatbuffers::Verifier verifier(data, buf.size(), 64, 3);
+  auto &stats = Verify(&verifier, false);
+  TEST_EQ(stats.failure, flatbuffers::Verifier::kTooManyTables);
+  TEST_EQ(stats.failure_offset, 0);
+  TEST_EQ(stats.failure_table, child2);
+  TEST_EQ(stats.failure_field, 0);
+  TEST_EQ(verifier.GetNumTables(), 4U);
+
+  // With a depth limit as well, the enemy is too deep before the table
+  // limit is reached.
+  flatbuffers::Verifier deep_verifier(data, buf.size(), 2, 3);
+  auto &deep_stats = Verify(&deep_verifier, false);
+  TEST_EQ(deep_stats.failure, flatbuffers::Verifier::kTooDeep);
+  TEST_EQ(deep_stats.failure_table,
+          OffsetOf(buf,
+                   GetMonster(data)->testarrayoftables()->Get(0)->enemy()));
+}
+
+// Bounds-checked accessors (see --gen-bounds-checked) check only what they
+// read, and read corrupt or truncated data as absent.
+void BoundsCheckedAccessTest() {
+  auto buf = CreateFamily();
+  auto data = reinterpret_cast<uint8_t *>(&buf[0]);
+  flatbuffers::Verifier verifier(data, buf.size());
+  auto &stats = verifier.GetStats();
+  auto monster = GetMonsterChecked(verifier);
+  TEST_NOTNULL(monster);
+  TEST_EQ(stats.bytes_verified, sizeof(flatbuffers::uoffset_t));
+  // Bytes checked since the last call.
+  size_t checked = stats.bytes_verified;
+  auto bytes = [&]() {
+    auto b = stats.bytes_verified - checked;
+    checked = stats.bytes_verified;
+    return b;
+  };
+  // A scalar: the vtable offset, vtable size, field offset and field.
+  TEST_EQ(monster->hp(verifier), 80);
+  TEST_EQ(bytes(), 4U + 2 + 2 + 2);
+  // A scalar left at its default, so with no field to check.
+  TEST_EQ(monster->mana(verifier), 150);
+  TEST_EQ(bytes(), 4U + 2 + 2);
+  // A string: also its offset, length, 4 characters and terminator. The
+  // length gets checked twice, on its own and as part of the string.
+  TEST_EQ_STR(monster->name(verifier)->c_str(), "root");
+  TEST_EQ(bytes(), 4U + 2 + 2 + 4 + 4 + (4 + 4) + 1);
+  // An absent table.
+  TEST_EQ(monster->enemy(verifier) == nullptr, true);
+  TEST_EQ(bytes(), 4U + 2 + 2);
+  // A vector of tables: its offset and the whole vector, but none of the
+  // tables in it.
+  TEST_EQ(monster->testarrayoftables(verifier)->size(), 2U);
+  TEST_EQ(bytes(), 4U + 2 + 2 + 4 + 4 + (4 + 2 * 4));
+  // Nothing else was checked: no table was verified as a whole.
+  TEST_EQ(verifier.GetNumTables(), 0U);
+  TEST_EQ(stats.failure, flatbuffers::Verifier::kNoFailure);
+
+  // Truncated just after the root table, such that the root name (created
+  // right before it, so stored right after it) is cut off.
+  auto name = OffsetOf(buf, monster->name());
+  flatbuffers::Verifier truncated(data, static_cast<size_t>(name) + 2);
+  monster = GetMonsterChecked(truncated);
+  TEST_EQ(monster->hp(truncated), 80);
+  TEST_EQ(monster->name(truncated) == nullptr, true);
+  TEST_EQ(monster->testarrayoftables(truncated) == nullptr, true);
+  TEST_EQ(truncated.GetStats().failure, flatbuffers::Verifier::kOutOfBounds);
+  TEST_EQ(truncated.GetStats().failure_offset, name);
+
+  // A vtable offset pointing past the end: all fields read as absent.
+  flatbuffers::WriteScalar(data + OffsetOf(buf, monster),
+                           -static_cast<flatbuffers::soffset_t>(buf.size()));
+  flatbuffers::Verifier corrupt(data, buf.size());
+  monster = GetMonsterChecked(corrupt);
+  TEST_EQ(monster->hp(corrupt), 100);  // The default.
+  TEST_EQ(monster->name(corrupt) == nullptr, true);
+  TEST_EQ(monster->pos(corrupt) == nullptr, true);
+  TEST_EQ(corrupt.GetStats().failure, flatbuffers::Verifier::kOutOfBounds);
+
+  // Too small to even hold the root offset.
+  flatbuffers::Verifier tiny(data, 2);
+  TEST_EQ(GetMonsterChecked(tiny) == nullptr, true);
+}
+
+int main(int /*argc*/, const char * /*argv*/[]) {
+  VerifierStatsTest();
+  BadVTableTest();
+  StringPastEndTest();
+  TooManyTablesTest();
+  BoundsCheckedAccessTest();
+
+  if (!testing_fails) {
+    TEST_OUTPUT_LINE("ALL TESTS PASSED");
+    return 0;
+  } else {
+    TEST_OUTPUT_LINE("%d FAILED TESTS", testing_fails);
+    return 1;
+  }
+}